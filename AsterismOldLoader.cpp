@@ -21,12 +21,12 @@
 #include <limits>
 #include <ostream>
 #include <QDir>
-#include <QFile>
 #include <QDebug>
-#include <QRegularExpression>
 
 #include "AsterismOldLoader.hpp"
 #include "Utils.hpp"
+#include "Regex.hpp"
+#include "Diagnostics.hpp"
 
 std::ostream& operator<<(std::ostream& s, const AsterismOldLoader::Asterism::Star& star)
 {
@@ -93,7 +93,8 @@ void AsterismOldLoader::load(const QString& skyCultureDir, const QString& cultur
 {
 	this->cultureId = cultureId;
 	QString fic = skyCultureDir+"/asterism_lines.fab";
-	if (QFileInfo(fic).exists())
+	progress->report("asterisms", "asterism_lines.fab", 0, 2);
+	if (fileSystem->exists(fic))
 	{
 		hasAsterism = true;
 		loadLines(fic);
@@ -104,24 +105,28 @@ void AsterismOldLoader::load(const QString& skyCultureDir, const QString& cultur
 		qWarning() << "No asterisms found";
 	}
 
+	if (progress->cancelled()) return;
+
 	// load asterism names
 	fic = skyCultureDir + "/asterism_names.eng.fab";
-	if (QFileInfo(fic).exists())
+	progress->report("asterisms", "asterism_names.eng.fab", 1, 2);
+	if (fileSystem->exists(fic))
 		loadNames(fic);
 }
 
 void AsterismOldLoader::loadLines(const QString &fileName)
 {
-	QFile in(fileName);
-	if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto inDevice = fileSystem->open(fileName, QIODevice::ReadOnly | QIODevice::Text);
+	if (!inDevice)
 	{
 		qWarning() << "Can't open asterism data file" << QDir::toNativeSeparators(fileName);
 		return;
 	}
+	auto& in = *inDevice;
 
 	int totalRecords=0;
 	QString record;
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 	while (!in.atEnd())
 	{
 		record = QString::fromUtf8(in.readLine());
@@ -142,6 +147,7 @@ void AsterismOldLoader::loadLines(const QString &fileName)
 	int readOk = 0;			// count of records processed OK
 	while (!in.atEnd())
 	{
+		if (progress->cancelled()) return;
 		record = QString::fromUtf8(in.readLine());
 		currentLineNumber++;
 		if (commentRx.match(record).hasMatch())
@@ -155,7 +161,8 @@ void AsterismOldLoader::loadLines(const QString &fileName)
 		}
 		else
 		{
-			qWarning() << "ERROR reading asterism lines record at line" << currentLineNumber;
+			Diagnostics::error("parse-error", "cannot read asterism lines record",
+			                   QDir::toNativeSeparators(fileName), currentLineNumber);
 			delete aster;
 		}
 	}
@@ -175,18 +182,19 @@ void AsterismOldLoader::loadNames(const QString& namesFile)
 	}
 
 	// Open file
-	QFile commonNameFile(namesFile);
-	if (!commonNameFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto commonNameFileDevice = fileSystem->open(namesFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!commonNameFileDevice)
 	{
 		qDebug() << "Cannot open file" << QDir::toNativeSeparators(namesFile);
 		return;
 	}
+	auto& commonNameFile = *commonNameFileDevice;
 
 	// Now parse the file
 	// lines to ignore which start with a # or are empty
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
-	static const QRegularExpression recRx("^\\s*(\\S+)\\s+_[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)\\n");
-	static const QRegularExpression ctxRx("(.*)\",\\s*\"(.*)");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
+	const auto& recRx = Regex::get(Regex::AsterismNameRecord);
+	const auto& ctxRx = Regex::get(Regex::TranslationContext);
 
 	// keep track of how many records we processed.
 	int totalRecords=0;
@@ -195,13 +203,14 @@ void AsterismOldLoader::loadNames(const QString& namesFile)
 	QString translatorsComments;
 	while (!commonNameFile.atEnd())
 	{
+		if (progress->cancelled()) return;
 		QString record = QString::fromUtf8(commonNameFile.readLine());
 		lineNumber++;
 
 		const auto commentMatch = commentRx.match(record);
 		if (commentMatch.hasMatch())
 		{
-			const auto comment = commentMatch.captured(1).trimmed().replace(QRegularExpression("^#\\s*"), "");
+			const auto comment = Regex::get(Regex::CommentHashPrefix).replaced(commentMatch.captured(1).trimmed(), "");
 			if(comment.startsWith(translatorsCommentPrefix))
 				translatorsComments += comment.mid(translatorsCommentPrefix.size()).trimmed() + "\n";
 			else if(!comment.isEmpty())
@@ -214,7 +223,8 @@ void AsterismOldLoader::loadNames(const QString& namesFile)
 		QRegularExpressionMatch recMatch=recRx.match(record);
 		if (!recMatch.hasMatch())
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in asterism names file" << QDir::toNativeSeparators(namesFile) << ":" << record;
+			Diagnostics::error("parse-error", "cannot parse record in asterism names file: " + record.trimmed(),
+			                   QDir::toNativeSeparators(namesFile), lineNumber);
 		}
 		else
 		{
@@ -241,7 +251,8 @@ void AsterismOldLoader::loadNames(const QString& namesFile)
 			}
 			else
 			{
-				qWarning() << "WARNING - asterism abbreviation" << shortName << "not found when loading asterism names";
+				Diagnostics::warning("unknown-asterism", "asterism abbreviation " + shortName + " not found when loading asterism names",
+				                     QDir::toNativeSeparators(namesFile), lineNumber);
 			}
 		}
 		translatorsComments = "";
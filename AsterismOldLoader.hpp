@@ -22,6 +22,8 @@
 #include <cmath>
 #include <vector>
 #include <QString>
+#include "FileSystem.hpp"
+#include "Progress.hpp"
 
 class AsterismOldLoader
 {
@@ -69,6 +71,10 @@ public:
 	};
 
 	void load(const QString& skyCultureDir, const QString& cultureId);
+	//! Makes the loader read the files through fs instead of from the disk
+	void setFileSystem(const FileSystem& fs) { fileSystem = &fs; }
+	//! Makes the loader report its progress to p and stop early when it's cancelled
+	void setProgress(const Progress& p) { progress = &p; }
 	const Asterism* find(QString const& englishName) const;
 	bool dumpJSON(std::ostream& s) const;
 	auto begin() const { return asterisms.cbegin(); }
@@ -77,6 +83,8 @@ private:
 	QString cultureId;
 	bool hasAsterism = false;
 	std::vector<Asterism*> asterisms;
+	const FileSystem* fileSystem = &FileSystem::disk();
+	const Progress* progress = &Progress::none();
 
 	Asterism* findFromAbbreviation(const QString& abbrev) const;
 	void loadLines(const QString& fileName);
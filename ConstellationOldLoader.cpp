@@ -20,13 +20,75 @@
 #include "ConstellationOldLoader.hpp"
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
 #include <QDir>
-#include <QFile>
+#include <QBuffer>
 #include <QDebug>
 #include <QImage>
 #include <QFileInfo>
-#include <QRegularExpression>
+#include <QImageReader>
+#include <QElapsedTimer>
 #include "Utils.hpp"
+#include "Regex.hpp"
+#include "Diagnostics.hpp"
+#include "ConverterContext.hpp"
+#include "OutputDir.hpp"
+
+namespace
+{
+
+struct ImageProbeStats
+{
+	int probed = 0;
+	int fullyDecoded = 0;
+	qint64 elapsedNS = 0;
+	qint64 decodeBytesAvoided = 0;
+	qint64 largestDecodeAvoided = 0;
+
+	void report() const
+	{
+		if(!probed) return;
+		constexpr double MiB = 1024. * 1024.;
+		qDebug().nospace() << "Probed sizes of " << probed << " illustrations in " << elapsedNS / 1e6 << " ms ("
+		                   << fullyDecoded << " needed a full decode), avoided decoding "
+		                   << decodeBytesAvoided / MiB << " MiB of pixel data, peak decode memory reduced by "
+		                   << largestDecodeAvoided / MiB << " MiB";
+	}
+};
+
+// Gets the size of the image from its header, only decoding the image if the header lacks the dimensions
+QSize probeImageSize(const FileSystem& fileSystem, const QString& path, ImageProbeStats& stats)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	const auto device = fileSystem.open(path);
+	if(!device)
+		return {};
+	// The suffix is only a hint, the format is still detected from the contents if it's wrong
+	QImageReader reader(device.get(), QFileInfo(path).suffix().toLatin1());
+	auto size = reader.size();
+	if(size.isValid())
+	{
+		const int formatBits = QImage::toPixelFormat(reader.imageFormat()).bitsPerPixel();
+		const int bitsPerPixel = formatBits > 0 ? formatBits : 32;
+		const qint64 bytes = qint64(size.width()) * size.height() * bitsPerPixel / 8;
+		stats.decodeBytesAvoided += bytes;
+		stats.largestDecodeAvoided = std::max(stats.largestDecodeAvoided, bytes);
+	}
+	else
+	{
+		device->seek(0);
+		size = QImageReader(device.get()).read().size();
+		++stats.fullyDecoded;
+	}
+
+	++stats.probed;
+	stats.elapsedNS += timer.nsecsElapsed();
+	return size;
+}
+
+}
 
 bool ConstellationOldLoader::Constellation::read(QString const& record)
 {
@@ -60,27 +122,28 @@ void ConstellationOldLoader::loadSeasonalRules(const QString& rulesFile)
 	// Constellation not loaded yet
 	if (constellations.empty()) return;
 
-	if (!QFileInfo(rulesFile).exists())
+	if (!fileSystem->exists(rulesFile))
 	{
 		// Current starlore didn't support the seasonal rules
 		return;
 	}
 
 	// Open file
-	QFile seasonalRulesFile(rulesFile);
-	if (!seasonalRulesFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto seasonalRulesFileDevice = fileSystem->open(rulesFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!seasonalRulesFileDevice)
 	{
 		qDebug() << "Cannot open file" << QDir::toNativeSeparators(rulesFile);
 		return;
 	}
+	auto& seasonalRulesFile = *seasonalRulesFileDevice;
 
 	// Now parse the file
 	// lines to ignore which start with a # or are empty
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 
 	// lines which look like records - we use the RE to extract the fields
 	// which will be available in recRx.capturedTexts()
-	static const QRegularExpression recRx("^\\s*(\\w+)\\s+(\\w+)\\s+(\\w+)\\n");
+	const auto& recRx = Regex::get(Regex::SeasonalRuleRecord);
 
 	// Some more variables to use in the parsing
 	Constellation *aster;
@@ -92,6 +155,7 @@ void ConstellationOldLoader::loadSeasonalRules(const QString& rulesFile)
 	int lineNumber=0;
 	while (!seasonalRulesFile.atEnd())
 	{
+		if (progress->cancelled()) return;
 		record = QString::fromUtf8(seasonalRulesFile.readLine());
 		lineNumber++;
 
@@ -104,7 +168,8 @@ void ConstellationOldLoader::loadSeasonalRules(const QString& rulesFile)
 		QRegularExpressionMatch recMatch=recRx.match(record);
 		if (!recMatch.hasMatch())
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in seasonal rules file" << QDir::toNativeSeparators(rulesFile);
+			Diagnostics::error("parse-error", "cannot parse record in seasonal rules file",
+			                   QDir::toNativeSeparators(rulesFile), lineNumber);
 		}
 		else
 		{
@@ -120,7 +185,9 @@ void ConstellationOldLoader::loadSeasonalRules(const QString& rulesFile)
 			}
 			else
 			{
-				qWarning() << "WARNING - constellation abbreviation" << shortName << "not found when loading seasonal rules for constellations";
+				Diagnostics::warning("unknown-constellation", "constellation abbreviation " + shortName +
+				                     " not found when loading seasonal rules for constellations",
+				                     QDir::toNativeSeparators(rulesFile), lineNumber);
 			}
 		}
 	}
@@ -135,20 +202,22 @@ auto ConstellationOldLoader::findFromAbbreviation(const QString& abbrev) -> Cons
 	return nullptr;
 }
 
-void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, const QString& outDir)
+void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, OutputDir& outDir)
 {
 	const auto fileName = skyCultureDir+"/constellationship.fab";
 	const auto artfileName = skyCultureDir+"/constellationsart.fab";
-	QFile in(fileName);
-	if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
+	auto inDevice = fileSystem->open(fileName, QIODevice::ReadOnly | QIODevice::Text);
+	if (!inDevice)
 	{
 		qWarning() << "Can't open constellation data file" << QDir::toNativeSeparators(fileName);
 		Q_ASSERT(0);
+		inDevice = std::make_unique<QBuffer>(); // not open, so it reads as empty
 	}
+	auto& in = *inDevice;
 
 	int totalRecords=0;
 	QString record;
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$"); // pure comment lines or empty lines
+	const auto& commentRx = Regex::get(Regex::FabCommentLine); // pure comment lines or empty lines
 	while (!in.atEnd())
 	{
 		record = QString::fromUtf8(in.readLine());
@@ -165,6 +234,7 @@ void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, const
 	int readOk = 0;			// count of records processed OK
 	while (!in.atEnd())
 	{
+		if (progress->cancelled()) return;
 		record = QString::fromUtf8(in.readLine());
 		currentLineNumber++;
 		if (commentRx.match(record).hasMatch())
@@ -178,7 +248,8 @@ void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, const
 		}
 		else
 		{
-			qWarning() << "ERROR reading constellation lines record at line" << currentLineNumber;
+			Diagnostics::error("parse-error", "cannot read constellation lines record",
+			                   QDir::toNativeSeparators(fileName), currentLineNumber);
 			constellations.pop_back();
 		}
 	}
@@ -187,17 +258,18 @@ void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, const
 		qDebug() << "Loaded" << readOk << "/" << totalRecords << "constellation records successfully";
 
 	// It's possible to have no art - just constellations
-	if (!QFileInfo(artfileName).exists())
+	if (!fileSystem->exists(artfileName))
      {
           qWarning() << "No constellation art found";
 		return;
      }
-	QFile fic(artfileName);
-	if (!fic.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto ficDevice = fileSystem->open(artfileName, QIODevice::ReadOnly | QIODevice::Text);
+	if (!ficDevice)
 	{
 		qWarning() << "Can't open constellation art file" << QDir::toNativeSeparators(artfileName);
 		return;
 	}
+	auto& fic = *ficDevice;
 
 	totalRecords=0;
 	while (!fic.atEnd())
@@ -222,9 +294,11 @@ void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, const
 
 	currentLineNumber = 0;	// line in file
 	readOk = 0;		// count of records processed OK
+	ImageProbeStats probeStats;
 
 	while (!fic.atEnd())
 	{
+		if (progress->cancelled()) return;
 		++currentLineNumber;
 		record = QString::fromUtf8(fic.readLine());
 		if (commentRx.match(record).hasMatch())
@@ -236,85 +310,54 @@ void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, const
 		rStr >> shortname >> texfile >> x1 >> y1 >> hp1 >> x2 >> y2 >> hp2 >> x3 >> y3 >> hp3;
 		if (rStr.status()!=QTextStream::Ok)
 		{
-			qWarning() << "ERROR parsing constellation art record at line" << currentLineNumber << "of art file";
+			Diagnostics::error("parse-error", "cannot parse constellation art record",
+			                   QDir::toNativeSeparators(artfileName), currentLineNumber);
 			continue;
 		}
 
 		cons = findFromAbbreviation(shortname);
 		if (!cons)
 		{
-			qWarning() << "ERROR in constellation art file at line" << currentLineNumber
-					   << "constellation" << shortname << "unknown";
+			Diagnostics::error("unknown-constellation", "constellation " + shortname + " unknown",
+			                   QDir::toNativeSeparators(artfileName), currentLineNumber);
 		}
 		else
 		{
 			cons->artTexture = "illustrations/" + texfile;
 			const auto texPath = skyCultureDir+"/"+texfile;
-			QImage tex(texPath);
-			if(tex.isNull())
+			const auto texSize = probeImageSize(*fileSystem, texPath, probeStats);
+			if(!texSize.isValid())
 			{
-				std::cerr << "Error: failed to open texture file \"" << texPath.toStdString() << "\"\n";
+				Diagnostics::error("missing-texture", "failed to open texture file \"" + QDir::toNativeSeparators(texPath) + "\"",
+				                   QDir::toNativeSeparators(artfileName), currentLineNumber);
 			}
 			else
 			{
-				cons->textureSize = tex.size();
-
-				const auto targetPath = outDir+"/"+cons->artTexture;
-				if(!QDir().mkpath(QFileInfo(targetPath).absoluteDir().path()))
-				{
-					qCritical() << "Failed to create output directory for texture file" << targetPath;
-					continue;
-				}
-
-				const auto texInfo = QFileInfo(texPath);
-				const auto targetInfo = QFileInfo(targetPath);
-				bool targetExistsAndDiffers = targetInfo.exists() && texInfo.size() != targetInfo.size();
-				if(targetInfo.exists() && !targetExistsAndDiffers)
-				{
-					// Check that the contents are the same
-					QFile in(texPath);
-					if(!in.open(QFile::ReadOnly))
-					{
-						qCritical().noquote() << "Failed to open file" << texPath;
-						continue;
-					}
-					QFile out(targetPath);
-					if(!out.open(QFile::ReadOnly))
-					{
-						qCritical().noquote() << "Failed to open file" << targetPath;
-						continue;
-					}
-					targetExistsAndDiffers = in.readAll() != out.readAll();
-				}
-				if(targetExistsAndDiffers)
-				{
-					qCritical() << "Image file names collide:" << texPath << "and" << targetPath;
-					continue;
-				}
-
-				// If it exists, it is the same as the file we're trying to copy, so don't copy it in that case
-				if(!targetInfo.exists())
-				{
-					QFile file(texPath);
-					if(!file.copy(targetPath))
-					{
-						std::cerr << "Error: failed to copy texture file \"" << texPath.toStdString()
-						          << "\" to \"" << targetPath.toStdString() << "\""
-						          << ": " << file.errorString().toStdString() << "\n";
-					}
-				}
+				cons->textureSize = texSize;
+				if(maxTextureSize > 0 && std::max(texSize.width(), texSize.height()) > maxTextureSize)
+					cons->textureSize = texSize.scaled(maxTextureSize, maxTextureSize, Qt::KeepAspectRatio)
+					                           .expandedTo(QSize(1, 1)); // very elongated images mustn't collapse
+				// Copying runs in the background, failures are reported by OutputDir::waitForPublishing()
+				if(cons->textureSize == texSize)
+					outDir.publishFileAsync(texPath, cons->artTexture);
+				else
+					outDir.publishImageAsync(texPath, cons->artTexture, cons->textureSize);
 			}
 
-			cons->artP1.x = x1;
-			cons->artP1.y = y1;
+			// The anchor coordinates refer to the texture as it's written to the output
+			const double scaleX = texSize.isValid() ? double(cons->textureSize.width()) / texSize.width() : 1;
+			const double scaleY = texSize.isValid() ? double(cons->textureSize.height()) / texSize.height() : 1;
+
+			cons->artP1.x = std::lround(x1 * scaleX);
+			cons->artP1.y = std::lround(y1 * scaleY);
 			cons->artP1.hip = hp1;
 
-			cons->artP2.x = x2;
-			cons->artP2.y = y2;
+			cons->artP2.x = std::lround(x2 * scaleX);
+			cons->artP2.y = std::lround(y2 * scaleY);
 			cons->artP2.hip = hp2;
 
-			cons->artP3.x = x3;
-			cons->artP3.y = y3;
+			cons->artP3.x = std::lround(x3 * scaleX);
+			cons->artP3.y = std::lround(y3 * scaleY);
 			cons->artP3.hip = hp3;
 
 			++readOk;
@@ -323,6 +366,7 @@ void ConstellationOldLoader::loadLinesAndArt(const QString& skyCultureDir, const
 
 	if(readOk != totalRecords)
 		qDebug() << "Loaded" << readOk << "/" << totalRecords << "constellation art records successfully";
+	probeStats.report();
 	fic.close();
 }
 
@@ -334,21 +378,22 @@ void ConstellationOldLoader::loadNativeNames(const QString& skyCultureDir, const
 	if (constellations.empty()) return;
 
 	// Open file
-	QFile nativeNameFile(namesFile);
-	if (!nativeNameFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto nativeNameFileDevice = fileSystem->open(namesFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!nativeNameFileDevice)
 	{
 		qDebug() << "Cannot open file" << QDir::toNativeSeparators(namesFile);
 		return;
 	}
+	auto& nativeNameFile = *nativeNameFileDevice;
 
 	// Now parse the file
 	// lines to ignore which start with a # or are empty
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 
 	// lines which look like records - we use the RE to extract the fields
 	// which will be available in recRx.capturedTexts()
 	// abbreviation is allowed to start with a dot to mark as "hidden".
-	static const QRegularExpression recRx("^\\s*(\\.?\\S+)\\s+\"(.*)\"\\s+_[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)\\n");
+	const auto& recRx = Regex::get(Regex::ConstellationNameRecord);
 
 	// keep track of how many records we processed.
 	int totalRecords=0;
@@ -356,17 +401,19 @@ void ConstellationOldLoader::loadNativeNames(const QString& skyCultureDir, const
 	int lineNumber=0;
 	while (!nativeNameFile.atEnd())
 	{
+		if (progress->cancelled()) return;
 		QString record = QString::fromUtf8(nativeNameFile.readLine());
 		lineNumber++;
 
-		if (record.contains(commentRx)) continue;
+		if (commentRx.matches(record)) continue;
 
 		totalRecords++;
 
 		QRegularExpressionMatch recMatch=recRx.match(record);
 		if (!recMatch.hasMatch())
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in native constellation names file" << QDir::toNativeSeparators(namesFile) << ":" << record;
+			Diagnostics::error("parse-error", "cannot parse record in native constellation names file: " + record.trimmed(),
+			                   QDir::toNativeSeparators(namesFile), lineNumber);
 		}
 		else
 		{
@@ -378,7 +425,8 @@ void ConstellationOldLoader::loadNativeNames(const QString& skyCultureDir, const
 				const auto native = recMatch.captured(3).trimmed();
 				if (native.isEmpty())
 				{
-					qWarning() << "Warning: empty native name at line" << lineNumber << "in native constellation names file" << QDir::toNativeSeparators(namesFile) << ":" << record;
+					Diagnostics::warning("missing-native-name", "empty native name: " + record.trimmed(),
+					                     QDir::toNativeSeparators(namesFile), lineNumber);
 					continue;
 				}
 
@@ -390,8 +438,9 @@ void ConstellationOldLoader::loadNativeNames(const QString& skyCultureDir, const
 			}
 			else
 			{
-				qWarning() << "WARNING - constellation abbreviation" << shortName
-				           << "not found when loading native constellation names";
+				Diagnostics::warning("unknown-constellation", "constellation abbreviation " + shortName +
+				                     " not found when loading native constellation names",
+				                     QDir::toNativeSeparators(namesFile), lineNumber);
 			}
 		}
 	}
@@ -412,22 +461,23 @@ void ConstellationOldLoader::loadNames(const QString& skyCultureDir)
 	}
 
 	// Open file
-	QFile commonNameFile(namesFile);
-	if (!commonNameFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto commonNameFileDevice = fileSystem->open(namesFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!commonNameFileDevice)
 	{
 		qDebug() << "Cannot open file" << QDir::toNativeSeparators(namesFile);
 		return;
 	}
+	auto& commonNameFile = *commonNameFileDevice;
 
 	// Now parse the file
 	// lines to ignore which start with a # or are empty
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 
 	// lines which look like records - we use the RE to extract the fields
 	// which will be available in recRx.capturedTexts()
 	// abbreviation is allowed to start with a dot to mark as "hidden".
-	static const QRegularExpression recRx("^\\s*(\\.?\\S+)\\s+\"(.*)\"\\s+_[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)\\n");
-	static const QRegularExpression ctxRx("(.*)\",\\s*\"(.*)");
+	const auto& recRx = Regex::get(Regex::ConstellationNameRecord);
+	const auto& ctxRx = Regex::get(Regex::TranslationContext);
 
 	// keep track of how many records we processed.
 	int totalRecords=0;
@@ -436,13 +486,14 @@ void ConstellationOldLoader::loadNames(const QString& skyCultureDir)
 	QString translatorsComments;
 	while (!commonNameFile.atEnd())
 	{
+		if (progress->cancelled()) return;
 		QString record = QString::fromUtf8(commonNameFile.readLine());
 		lineNumber++;
 
 		const auto commentMatch = commentRx.match(record);
 		if (commentMatch.hasMatch())
 		{
-			const auto comment = commentMatch.captured(1).trimmed().replace(QRegularExpression("^#\\s*"), "");
+			const auto comment = Regex::get(Regex::CommentHashPrefix).replaced(commentMatch.captured(1).trimmed(), "");
 			if(comment.startsWith(translatorsCommentPrefix))
 				translatorsComments += comment.mid(translatorsCommentPrefix.size()).trimmed() + "\n";
 			else if(!comment.isEmpty())
@@ -455,7 +506,8 @@ void ConstellationOldLoader::loadNames(const QString& skyCultureDir)
 		QRegularExpressionMatch recMatch=recRx.match(record);
 		if (!recMatch.hasMatch())
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in constellation names file" << QDir::toNativeSeparators(namesFile) << ":" << record;
+			Diagnostics::error("parse-error", "cannot parse record in constellation names file: " + record.trimmed(),
+			                   QDir::toNativeSeparators(namesFile), lineNumber);
 		}
 		else
 		{
@@ -483,7 +535,9 @@ void ConstellationOldLoader::loadNames(const QString& skyCultureDir)
 			}
 			else
 			{
-				qWarning() << "WARNING - constellation abbreviation" << shortName << "not found when loading constellation names";
+				Diagnostics::warning("unknown-constellation", "constellation abbreviation " + shortName +
+				                     " not found when loading constellation names",
+				                     QDir::toNativeSeparators(namesFile), lineNumber);
 			}
 		}
 		translatorsComments = "";
@@ -493,28 +547,22 @@ void ConstellationOldLoader::loadNames(const QString& skyCultureDir)
 		qDebug() << "Loaded" << readOk << "/" << totalRecords << "constellation names";
 }
 
-void ConstellationOldLoader::loadBoundaries(const QString& skyCultureDir)
+auto ConstellationOldLoader::readBoundaries(const FileSystem& fs, const QString& boundaryFile) -> std::shared_ptr<const BoundaryList>
 {
-	if(QString(boundariesType.c_str()).toLower() == "none")
-		return;
-
-	const bool ownB = QString(boundariesType.c_str()).toLower() == "own";
-	const auto boundaryFile = ownB ? skyCultureDir + "/constellation_boundaries.dat"
-	                               : skyCultureDir + "/../../data/constellation_boundaries.dat";
-
 	// Modified boundary file by Torsten Bronger with permission
 	// http://pp3.sourceforge.net
-	QFile dataFile(boundaryFile);
-	if (!dataFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto dataFileDevice = fs.open(boundaryFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!dataFileDevice)
 	{
 		qWarning() << "Boundary file" << QDir::toNativeSeparators(boundaryFile) << "not found";
-		return;
+		return nullptr;
 	}
+	auto& dataFile = *dataFileDevice;
 
 	QString data = "";
 
 	// Added support of comments for constellation_boundaries.dat file
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 	while (!dataFile.atEnd())
 	{
 		// Read the line
@@ -528,7 +576,7 @@ void ConstellationOldLoader::loadBoundaries(const QString& skyCultureDir)
 		data.append(record);
 	}
 
-	boundaries.clear();
+	auto boundaries = std::make_shared<BoundaryList>();
 	// Read and parse the data without comments
 	QTextStream istr(&data);
 	unsigned int i = 0;
@@ -539,8 +587,8 @@ void ConstellationOldLoader::loadBoundaries(const QString& skyCultureDir)
 		if(num == 0)
 			continue; // empty line
 
-		boundaries.push_back({});
-		auto& line = boundaries.back();
+		boundaries->push_back({});
+		auto& line = boundaries->back();
 		auto& points = line.points;
 
 		for (unsigned int j=0;j<num;j++)
@@ -554,9 +602,9 @@ void ConstellationOldLoader::loadBoundaries(const QString& skyCultureDir)
 		istr >> numc;
 		if(numc != 2)
 		{
-			std::cerr << "Error: expected 2 constellations per boundary, got " << numc << "\n";
-			boundaries.clear();
-			return;
+			Diagnostics::error("parse-error", QString("expected 2 constellations per boundary, got %1").arg(numc),
+			                   QDir::toNativeSeparators(boundaryFile));
+			return nullptr;
 		}
 
 		istr >> line.cons1;
@@ -566,22 +614,67 @@ void ConstellationOldLoader::loadBoundaries(const QString& skyCultureDir)
 		i++;
 	}
 	qDebug() << "Loaded" << i << "constellation boundary segments";
+	return boundaries;
+}
+
+void ConstellationOldLoader::loadBoundaries(const QString& skyCultureDir)
+{
+	boundaries.clear();
+	genericBoundariesMissing = false;
+	if(QString(boundariesType.c_str()).toLower() == "none")
+		return;
+
+	std::shared_ptr<const BoundaryList> loaded;
+	if(QString(boundariesType.c_str()).toLower() == "own")
+	{
+		loaded = readBoundaries(*fileSystem, skyCultureDir + "/constellation_boundaries.dat");
+	}
+	else
+	{
+		// The generic boundaries aren't a part of the sky culture, so a sky culture that isn't
+		// on the disk has no place to take them from unless their file is given explicitly
+		const auto& fs = genericBoundariesFile.isEmpty() ? *fileSystem : FileSystem::disk();
+		const auto boundaryFile = genericBoundariesFile.isEmpty() ? skyCultureDir + "/../../data/constellation_boundaries.dat"
+		                                                          : genericBoundariesFile;
+		const auto localFile = fs.localPath(boundaryFile);
+		if(localFile.isEmpty())
+		{
+			Diagnostics::error("boundaries-not-found", "The sky culture uses the generic constellation boundaries, "
+			                   "but it isn't on the disk, so their file must be given with --generic-boundaries "
+			                   "(ConvertOptions::genericBoundariesFile)");
+			genericBoundariesMissing = true;
+			return;
+		}
+
+		// The generic boundaries are shared by most sky cultures, so they are parsed once per context
+		if(context)
+			loaded = context->cachedFile<BoundaryList>(localFile, [&fs, &boundaryFile](const QString&)
+			                                           { return readBoundaries(fs, boundaryFile); });
+		else
+			loaded = readBoundaries(fs, boundaryFile);
+	}
+	if(loaded)
+		boundaries = *loaded;
 }
 
-void ConstellationOldLoader::load(const QString& skyCultureDir, const QString& outDir,
+void ConstellationOldLoader::load(const QString& skyCultureDir, OutputDir& outDir,
                                   const QString& nativeLocale)
 {
 	skyCultureName = QFileInfo(skyCultureDir).fileName();
+	progress->report("constellations", "constellationship.fab", 0, 4);
 	loadLinesAndArt(skyCultureDir, outDir);
+	if(progress->cancelled()) return;
+	progress->report("constellations", "constellation_names.eng.fab", 1, 4);
 	loadNames(skyCultureDir);
 	if(!nativeLocale.isEmpty())
 		loadNativeNames(skyCultureDir, nativeLocale);
+	if(progress->cancelled()) return;
 
 	for(const auto& cons : constellations)
 	{
 		if(cons.englishName.isEmpty())
 		{
-			std::cerr << "WARNING: constellation " << cons.abbreviation.toStdString() << " has no English name\n";
+			Diagnostics::warning("missing-english-name", "constellation " + cons.abbreviation + " has no English name");
 		}
 		if(cons.artTexture.isEmpty())
 		{
@@ -590,12 +683,16 @@ void ConstellationOldLoader::load(const QString& skyCultureDir, const QString& o
 		}
 		if(cons.textureSize.width() <= 0 || cons.textureSize.height() <= 0)
 		{
-			std::cerr << "Failed to find texture size for constellation " << cons.englishName.toStdString() << " (" << cons.abbreviation.toStdString() << ")\n";
+			Diagnostics::error("missing-texture", "failed to find texture size for constellation " +
+			                   cons.englishName + " (" + cons.abbreviation + ")");
 			continue;
 		}
 	}
 
+	progress->report("constellations", "constellation_boundaries.dat", 2, 4);
 	loadBoundaries(skyCultureDir);
+	if(progress->cancelled()) return;
+	progress->report("constellations", "seasonal_rules.fab", 3, 4);
 	loadSeasonalRules(skyCultureDir + "/seasonal_rules.fab");
 }
 
@@ -19,11 +19,16 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <iostream>
 #include <QSize>
 #include <QString>
+#include "FileSystem.hpp"
+#include "Progress.hpp"
 
+class OutputDir;
+class ConverterContext;
 class ConstellationOldLoader
 {
 public:
@@ -61,23 +66,44 @@ private:
 		std::vector<RaDec> points;
 		QString cons1, cons2;
 	};
-	std::vector<BoundaryLine> boundaries;
+	using BoundaryList = std::vector<BoundaryLine>;
+	BoundaryList boundaries;
 	std::string boundariesType;
+	QString genericBoundariesFile;
+	bool genericBoundariesMissing = false;
+	int maxTextureSize = 0;
+	const FileSystem* fileSystem = &FileSystem::disk();
+	const Progress* progress = &Progress::none();
+	ConverterContext* context = nullptr;
 
 	Constellation* findFromAbbreviation(const QString& abbrev);
-	void loadLinesAndArt(const QString &skyCultureDir, const QString& outDir);
+	void loadLinesAndArt(const QString &skyCultureDir, OutputDir& outDir);
 	void loadBoundaries(const QString& skyCultureDir);
+	static std::shared_ptr<const BoundaryList> readBoundaries(const FileSystem& fs, const QString& boundaryFile);
 	void loadNames(const QString &skyCultureDir);
     void loadNativeNames(const QString& skyCultureDir, const QString& nativeLocale);
 	void loadSeasonalRules(const QString& rulesFile);
 	bool dumpBoundariesJSON(std::ostream& s) const;
 	bool dumpConstellationsJSON(std::ostream& s) const;
 public:
-	void load(const QString &skyCultureDir, const QString& outDir, const QString& nativeLocale);
+	void load(const QString &skyCultureDir, OutputDir& outDir, const QString& nativeLocale);
 	const Constellation* find(QString const& englishName) const;
 	bool dumpJSON(std::ostream& s) const;
 	bool hasBoundaries() const { return !boundaries.empty(); }
 	void setBoundariesType(std::string const& type) { boundariesType = type; }
+	//! Makes the loader read the generic boundaries from this file on the disk instead of from
+	//! data/constellation_boundaries.dat two levels above the sky culture directory
+	void setGenericBoundariesFile(const QString& path) { genericBoundariesFile = path; }
+	//! Whether the sky culture uses the generic boundaries, but load() had no file to read them from
+	bool lacksGenericBoundaries() const { return genericBoundariesMissing; }
+	//! Makes the art textures be downscaled so that neither of their dimensions exceeds maxSize. Zero disables downscaling.
+	void setMaxTextureSize(const int maxSize) { maxTextureSize = maxSize; }
+	//! Makes the loader read the files through fs instead of from the disk
+	void setFileSystem(const FileSystem& fs) { fileSystem = &fs; }
+	//! Makes the loader report its progress to p and stop early when it's cancelled
+	void setProgress(const Progress& p) { progress = &p; }
+	//! Makes the loader take the generic boundaries from the cache of ctx
+	void setContext(ConverterContext& ctx) { context = &ctx; }
 	auto begin() const { return constellations.cbegin(); }
 	auto end() const { return constellations.cend(); }
 };
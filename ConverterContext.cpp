@@ -0,0 +1,53 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "ConverterContext.hpp"
+
+#include <QFileInfo>
+
+ConverterContext::Version ConverterContext::versionOf(const QString& path)
+{
+	const QFileInfo info(path);
+	if(!info.isFile())
+		return {};
+	return {info.absoluteFilePath(), info.lastModified(), info.size()};
+}
+
+std::shared_ptr<const void> ConverterContext::find(const Key& key, const Version& version)
+{
+	std::lock_guard lock(mutex);
+	if(const auto it = entries.find(key); it != entries.end() &&
+	   it->second.modified == version.modified && it->second.size == version.size)
+	{
+		return it->second.value;
+	}
+	return nullptr;
+}
+
+void ConverterContext::store(const Key& key, const Version& version, std::shared_ptr<const void> value)
+{
+	std::lock_guard lock(mutex);
+	entries[key] = {version.modified, version.size, std::move(value)};
+}
+
+void ConverterContext::clear()
+{
+	std::lock_guard lock(mutex);
+	entries.clear();
+}
@@ -0,0 +1,96 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <memory>
+#include <utility>
+#include <typeindex>
+#include <QString>
+#include <QDateTime>
+
+//! Data derived from input files that several conversions made by the same program have in
+//! common, e.g. the catalogs of stellarium-skycultures/, the sky culture names of the stellarium/
+//! catalogs and the generic constellation boundaries.
+//! Each file is parsed once and reused while its size and modification time stay the same, so
+//! files edited between conversions are picked up. clear() drops everything. Only files on the
+//! disk are cached. A context may be used by several conversions at once.
+//!
+//! The compiled regular expressions and the configured HTML Tidy documents are shared by the
+//! whole process and aren't held here.
+class ConverterContext
+{
+public:
+	ConverterContext() = default;
+	ConverterContext(const ConverterContext&) = delete;
+	ConverterContext& operator=(const ConverterContext&) = delete;
+
+	//! Returns what read(path) returned for the file at path, calling it only if nothing of type
+	//! T with the tag is cached for the current version of the file. The tag tells apart the
+	//! values of the same type that different readers make of a file, e.g. the messages of
+	//! different contexts of a .po file. A nullptr result isn't cached.
+	template<typename T, typename Reader>
+	std::shared_ptr<const T> cachedFile(const QString& path, const QString& tag, Reader&& read)
+	{
+		const Version version = versionOf(path);
+		const Key key{version.path, std::type_index(typeid(T)), tag};
+		if(version.size < 0)
+			return read(path);
+		if(auto value = find(key, version))
+			return std::static_pointer_cast<const T>(std::move(value));
+		std::shared_ptr<const T> value = read(path);
+		if(value)
+			store(key, version, value);
+		return value;
+	}
+	//! Same as above, for the files that only one reader makes a T of
+	template<typename T, typename Reader>
+	std::shared_ptr<const T> cachedFile(const QString& path, Reader&& read)
+	{
+		return cachedFile<T>(path, QString(), std::forward<Reader>(read));
+	}
+
+	//! Drops all the cached data
+	void clear();
+
+private:
+	struct Version
+	{
+		QString path; // absolute
+		QDateTime modified;
+		qint64 size = -1;
+	};
+	struct Entry
+	{
+		QDateTime modified;
+		qint64 size = -1;
+		std::shared_ptr<const void> value;
+	};
+	using Key = std::tuple<QString/*absolute path*/, std::type_index, QString/*tag*/>;
+
+	static Version versionOf(const QString& path);
+	std::shared_ptr<const void> find(const Key& key, const Version& version);
+	void store(const Key& key, const Version& version, std::shared_ptr<const void> value);
+
+	std::mutex mutex;
+	std::map<Key, Entry> entries;
+};
@@ -24,19 +24,36 @@
 #include <map>
 #include <deque>
 #include <cctype>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <algorithm>
 #include <string_view>
 #include <unordered_map>
 #include <QDir>
+#include <QSet>
 #include <QFile>
 #include <QDebug>
 #include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QSaveFile>
 #include <QTextStream>
+#include <QLoggingCategory>
 #include <QDomDocument>
+#include <QCryptographicHash>
 #include <QRegularExpression>
 #include <gettext-po.h>
 #include <tidy.h>
 #include <tidybuffio.h>
+#include "Regex.hpp"
+#include "PoUtils.hpp"
+#include "Diagnostics.hpp"
+#include "ConverterContext.hpp"
+#include "OutputDir.hpp"
 #include "NamesOldLoader.hpp"
+#include "XHTMLStreamConverter.hpp"
 #include "AsterismOldLoader.hpp"
 #include "ConstellationOldLoader.hpp"
 
@@ -45,8 +62,7 @@ namespace
 
 QString stripComments(QString markdown)
 {
-	static const QRegularExpression commentPat("<!--.*?-->");
-	markdown.replace(commentPat, "");
+	Regex::get(Regex::HTMLComment).replaceIn(markdown, "");
 	return markdown;
 }
 
@@ -71,26 +87,25 @@ constexpr auto SkipEmptyParts = Qt::SkipEmptyParts;
 constexpr auto SkipEmptyParts = QString::SkipEmptyParts;
 #endif
 
-const QRegularExpression htmlSimpleImageRegex(R"reg(<img\b[^>/]*(?:\s+alt="([^"]+)")?\s+src="([^"]+)"(?:\s+alt="([^"]+)")?\s*/?>)reg");
-const QRegularExpression htmlGeneralImageRegex(R"reg(<img\b[^>/]*\s+src="([^"]+)"[^>/]*/?>)reg");
 
-QString readReferencesFile(const QString& inDir)
+QString readReferencesFile(const FileSystem& fileSystem, const QString& inDir)
 {
 	const auto path = inDir + "/reference.fab";
-	if (!QFileInfo(path).exists())
+	if (!fileSystem.exists(path))
 	{
 		qWarning() << "No reference file, assuming the references are in the description text.";
 		return "";
 	}
-	QFile file(path);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto fileDevice = fileSystem.open(path, QIODevice::ReadOnly | QIODevice::Text);
+	if (!fileDevice)
 	{
 		qWarning() << "WARNING - could not open" << QDir::toNativeSeparators(path);
 		return "";
 	}
+	auto& file = *fileDevice;
 	QString record;
 	// Allow empty and comment lines where first char (after optional blanks) is #
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 	QString reference = "## References\n\n";
 	int totalRecords=0;
 	int readOk=0;
@@ -103,11 +118,10 @@ QString readReferencesFile(const QString& inDir)
 			continue;
 
 		totalRecords++;
-		static const QRegularExpression refRx("\\|");
 		#if (QT_VERSION>=QT_VERSION_CHECK(5, 14, 0))
-		QStringList ref = record.split(refRx, Qt::KeepEmptyParts);
+		QStringList ref = record.split(Regex::get(Regex::ReferenceFieldSeparator).regex(), Qt::KeepEmptyParts);
 		#else
-		QStringList ref = record.split(refRx, QString::KeepEmptyParts);
+		QStringList ref = record.split(Regex::get(Regex::ReferenceFieldSeparator).regex(), QString::KeepEmptyParts);
 		#endif
 		// 1 - URID; 2 - Reference; 3 - URL (optional)
 		if (ref.count()<2)
@@ -137,66 +151,121 @@ QString readReferencesFile(const QString& inDir)
 void cleanupWhitespace(QString& markdown)
 {
 	// Clean too long chains of newlines
-	markdown.replace(QRegularExpression("\n[ \t]*\n[ \t]*\n+"), "\n\n");
+	Regex::get(Regex::RepeatedBlankLines).replaceIn(markdown, "\n\n");
 	// Same for such chains inside blockquotes
-	markdown.replace(QRegularExpression("\n>[ \t]*(?:\n>[ \t]*)+\n"), "\n>\n");
+	Regex::get(Regex::RepeatedBlankQuoteLines).replaceIn(markdown, "\n>\n");
 
 	// Remove trailing spaces
-	markdown.replace(QRegularExpression("[ \t]+\n"), "\n");
+	Regex::get(Regex::TrailingSpaces).replaceIn(markdown, "\n");
 
 	// Make unordered lists a bit denser
-	const QRegularExpression ulistSpaceListPattern("(\n -[^\n]+)\n+(\n \\-)");
+	const auto& ulistSpaceListPattern = Regex::get(Regex::SparseUnorderedList);
 	//  1. Remove space between odd and even entries
-	markdown.replace(ulistSpaceListPattern, "\\1\\2");
+	ulistSpaceListPattern.replaceIn(markdown, "\\1\\2");
 	//  2. Remove space between even and odd entries (same replacement rule)
-	markdown.replace(ulistSpaceListPattern, "\\1\\2");
+	ulistSpaceListPattern.replaceIn(markdown, "\\1\\2");
 
 	// Make ordered lists a bit denser
-	const QRegularExpression olistSpaceListPattern("(\n 1\\.[^\n]+)\n+(\n 1)");
+	const auto& olistSpaceListPattern = Regex::get(Regex::SparseOrderedList);
 	//  1. Remove space between odd and even entries
-	markdown.replace(olistSpaceListPattern, "\\1\\2");
+	olistSpaceListPattern.replaceIn(markdown, "\\1\\2");
 	//  2. Remove space between even and odd entries (same replacement rule)
-	markdown.replace(olistSpaceListPattern, "\\1\\2");
+	olistSpaceListPattern.replaceIn(markdown, "\\1\\2");
 
 	const bool startsWithList = markdown.startsWith(" 1. ") || markdown.startsWith(" - ");
 	markdown = (startsWithList ? " " : "") + markdown.trimmed() + "\n";
 }
 
-QString tidyHTML(const QString& html)
+// A TidyDoc configured for our needs. Creating and configuring a TidyDoc costs more than
+// parsing a typical description, so it is reused for all the documents processed by a thread.
+class TidyContext
 {
-	TidyDoc tdoc = tidyCreate();
-	TidyBuffer output = {};
-	TidyBuffer errbuf = {};
-	int rc = -1;
-	if(tidyOptSetBool(tdoc, TidyXhtmlOut, yes))
-		rc = tidySetErrorBuffer(tdoc, &errbuf);
-	if(rc >= 0)
-		rc = tidyParseString(tdoc, html.toStdString().c_str());
-	if(rc > 0)
+public:
+	TidyContext()
+	{
+		ok = tidyOptSetBool(doc, TidyXhtmlOut, yes) &&
+		     // QDomNode misbehaves with entities in HTML5 mode, so set XHTML 4.1 Transitional
+		     tidyOptSetValue(doc, TidyDoctype, "loose") &&
+		     tidyOptSetInt(doc, TidyWrapLen, 999999) &&
+		     tidyOptSetBool(doc, TidyForceOutput, yes) &&
+		     tidySetErrorBuffer(doc, &errbuf) >= 0;
+	}
+	~TidyContext()
 	{
-		// QDomNode misbehaves with entities in HTML5 mode, so set XHTML 4.1 Transitional
-		rc = tidyOptSetValue(tdoc, TidyDoctype, "loose") ? rc : -1;
+		tidyBufFree(&output);
+		tidyBufFree(&errbuf);
+		tidyRelease(doc);
 	}
-	if(rc > 0)
-		rc = tidyOptSetInt(tdoc, TidyWrapLen, 999999) ? rc : -1;
-	if(rc >= 0)
-		rc = tidyCleanAndRepair(tdoc);
-	if(rc > 1)
-		rc = tidyOptSetBool(tdoc, TidyForceOutput, yes) ? rc : -1;
-	if(rc >= 0)
-		rc = tidySaveBuffer(tdoc, &output);
+	TidyContext(const TidyContext&) = delete;
+	TidyContext& operator=(const TidyContext&) = delete;
 
-	QString out;
-	if(rc >= 0)
-		out = reinterpret_cast<const char*>(output.bp);
-	else
-		std::cerr << "ERROR: Failed to parse HTML with HTML Tidy:\n" << errbuf.bp << "\n";
+	bool isUsable() const { return ok; }
 
-	tidyBufFree(&output);
-	tidyBufFree(&errbuf);
-	tidyRelease(tdoc);
+	// Parses, cleans up and serializes the UTF-8 HTML document. On success the
+	// result is in the output buffer, which stays valid until the next call.
+	bool tidy(const QByteArray& html)
+	{
+		tidyBufClear(&output);
+		tidyBufClear(&errbuf);
+		int rc = tidyParseString(doc, html.constData());
+		if(rc >= 0)
+			rc = tidyCleanAndRepair(doc);
+		if(rc >= 0)
+			rc = tidySaveBuffer(doc, &output);
+		if(rc >= 0)
+			return true;
+
+		Diagnostics::error("html-parse-error", "Failed to parse HTML with HTML Tidy:\n" +
+		                   QString::fromUtf8(errbuf.bp ? reinterpret_cast<const char*>(errbuf.bp) : ""));
+		ok = false; // Don't trust the internal state of the document after a failure
+		return false;
+	}
 
-	return out;
+	QByteArray result() const
+	{
+		return QByteArray::fromRawData(reinterpret_cast<const char*>(output.bp), output.size);
+	}
+
+private:
+	TidyDoc doc = tidyCreate();
+	TidyBuffer output = {};
+	TidyBuffer errbuf = {};
+	bool ok = false;
+};
+
+// Tidies up the UTF-8 HTML document. The resulting XHTML refers to the
+// buffer of this thread's TidyDoc, so it's only valid until the next call.
+bool tidyHTML(const QByteArray& html, QByteArray& xhtml)
+{
+	thread_local std::unique_ptr<TidyContext> context;
+	if(!context || !context->isUsable())
+		context = std::make_unique<TidyContext>();
+
+	if(!context->tidy(html))
+		return false;
+	xhtml = context->result();
+	return true;
+}
+
+// Replaces the tags matching <tagName\s*> with the placeholder. All the characters
+// involved are ASCII, so the replacement can be done on UTF-8 bytes.
+void replaceBareTag(QByteArray& html, const QByteArray& tagStart, const QByteArray& placeholder)
+{
+	for(qsizetype pos = 0; (pos = html.indexOf(tagStart, pos)) >= 0; )
+	{
+		auto end = pos + tagStart.size();
+		while(end < html.size() && std::isspace(static_cast<unsigned char>(html[end])))
+			++end;
+		if(end < html.size() && html[end] == '>')
+		{
+			html.replace(pos, end + 1 - pos, placeholder);
+			pos += placeholder.size();
+		}
+		else
+		{
+			pos = end;
+		}
+	}
 }
 
 QString nodeTypeName(const QDomNode::NodeType type)
@@ -282,7 +351,7 @@ bool processTableRow(const QDomElement& rowNode, const bool firstRow, QString& m
 				bool h1emitted = true;
 				if(!processHTMLNode(el, true, false, h1emitted, columns.back()))
 				{
-					std::cerr << " in a table. Leaving the table in HTML format.\n";
+					Diagnostics::warning("html-structure", "Leaving the table in HTML format");
 					return false;
 				}
 			}
@@ -402,7 +471,7 @@ void processList(const QDomElement& listNode, QString& markdown)
 				bool h1emitted = true;
 				if(!processHTMLNode(el, true, false, h1emitted, items.back()))
 				{
-					std::cerr << " in a list. Leaving the list in HTML format.\n";
+					Diagnostics::warning("html-structure", "Leaving the list in HTML format");
 					formatListAsHTML(listNode, markdown);
 					return;
 				}
@@ -451,13 +520,13 @@ bool processHTMLNode(const QDomNode& parentNode, const bool insideTable, const b
 			{
 				if(insideTable)
 				{
-					std::cerr << "WARNING: Unexpected <h1> tag";
+					Diagnostics::warning("html-structure", "Unexpected <" + tagName + "> tag in a table or a list");
 					return false;
 				}
 
 				if(h1emitted)
 				{
-					std::cerr << "WARNING: Unexpected repeated <h1> tag. Demoting it to <h3>.\n";
+					Diagnostics::warning("html-structure", "Unexpected repeated <h1> tag. Demoting it to <h3>.");
 					markdown += "\n### ";
 					QString text;
 					processHTMLNode(n, insideTable, footnotesToRefs, h1emitted, text);
@@ -478,12 +547,12 @@ bool processHTMLNode(const QDomNode& parentNode, const bool insideTable, const b
 			{
 				if(insideTable)
 				{
-					std::cerr << "WARNING: Unexpected <h1> tag";
+					Diagnostics::warning("html-structure", "Unexpected <" + tagName + "> tag in a table or a list");
 					return false;
 				}
 
 				if(!h1emitted)
-					std::cerr << "ERROR: Unexpected <" << tagName.toStdString() << "> tag before any <h1> tag was found\n";
+					Diagnostics::error("html-structure", "Unexpected <" + tagName + "> tag before any <h1> tag was found");
 
 				const int level = tagName[1].toLatin1() - '0';
 				markdown += '\n';
@@ -522,7 +591,7 @@ bool processHTMLNode(const QDomNode& parentNode, const bool insideTable, const b
 				{
 					if(footnotesToRefs)
 					{
-						static const QRegularExpression footnote("^footnote-([0-9]+)$");
+						const auto& footnote = Regex::get(Regex::FootnoteId);
 						if(const auto match = footnote.match(el.attribute("id")); match.isValid())
 						{
 							addNewlineBeforeNodeIfNeeded(markdown);
@@ -619,7 +688,7 @@ bool processHTMLNode(const QDomNode& parentNode, const bool insideTable, const b
 					{
 						if(const auto el = child.toElement(); el.tagName() == "a")
 						{
-							static const QRegularExpression footnote("^#footnote-([0-9]+)$");
+							const auto& footnote = Regex::get(Regex::FootnoteHref);
 							if(const auto match = footnote.match(el.attribute("href")); match.isValid())
 							{
 								markdown += "[#";
@@ -654,7 +723,7 @@ bool processHTMLNode(const QDomNode& parentNode, const bool insideTable, const b
 			}
 			else
 			{
-				qDebug() << "WARNING: Unhandled HTML element:" << n.toElement().tagName();
+				Diagnostics::warning("unhandled-element", "Unhandled HTML element: " + n.toElement().tagName());
 			}
 			break;
 		}
@@ -690,43 +759,24 @@ bool processHTMLNode(const QDomNode& parentNode, const bool insideTable, const b
 	return true;
 }
 
-[[nodiscard]] QString convertHTMLToMarkdown(QString htmlIn, const bool footnotesToRefs)
+// htmlIn is the HTML document encoded in UTF-8
+[[nodiscard]] QString convertHTMLToMarkdown(QByteArray htmlIn, const bool footnotesToRefs)
 {
 	// Replace <notr> and </notr> tags with placeholders that
 	// don't look like tags, so as not to confuse libTidy.
-	const QString notrOpenPlaceholder = "{22c35d6a-5ec3-4405-aeff-e79998dc95f7}";
-	const QString notrClosePlaceholder = "{2543be41-c785-4283-a4cf-ce5471d2c422}";
-	htmlIn.replace(QRegularExpression("<notr\\s*>"), notrOpenPlaceholder);
-	htmlIn.replace(QRegularExpression("</notr\\s*>"), notrClosePlaceholder);
-
-	const auto html = tidyHTML(htmlIn);
+	const char* const notrOpenPlaceholder = "{22c35d6a-5ec3-4405-aeff-e79998dc95f7}";
+	const char* const notrClosePlaceholder = "{2543be41-c785-4283-a4cf-ce5471d2c422}";
+	replaceBareTag(htmlIn, "<notr", notrOpenPlaceholder);
+	replaceBareTag(htmlIn, "</notr", notrClosePlaceholder);
 
-	QString markdown;
-
-	QDomDocument dom;
-	dom.setContent(html);
-
-	QDomNode n;
-	bool bodyFound = false;
-	for(n = dom.firstChild(); !n.isNull(); n = n.nextSibling())
-	{
-		if(n.isElement() && n.toElement().tagName() == "html")
-			for(n = n.firstChild(); !n.isNull(); n = n.nextSibling())
-				if(n.isElement() && n.toElement().tagName() == "body")
-				{
-					bodyFound = true;
-					goto afterBodyFound;
-				}
-	}
-	if(!bodyFound)
-	{
-		std::cerr << "Failed to found HTML <body> tag in tidied HTML\n";
+	QByteArray xhtml;
+	if(!tidyHTML(htmlIn, xhtml))
 		return {};
-	}
-afterBodyFound:
 
-	bool h1emitted = false;
-	processHTMLNode(n, false, footnotesToRefs, h1emitted, markdown);
+	// Most descriptions can be converted in a single pass over the XHTML. The DOM is
+	// only needed to keep some of the elements in HTML format, so fall back to it then.
+	auto converted = convertXHTMLToMarkdown(xhtml, footnotesToRefs);
+	QString markdown = converted ? *std::move(converted) : convertXHTMLToMarkdownWithDOM(xhtml, footnotesToRefs);
 
 	// Restore the reserved tags
 	markdown.replace(notrOpenPlaceholder,  "<notr>");
@@ -735,26 +785,27 @@ afterBodyFound:
 	return markdown;
 }
 
-void addMissingTextToMarkdown(QString& markdown, const QString& inDir, const QString& author, const QString& credit, const QString& license)
+void addMissingTextToMarkdown(QString& markdown, const FileSystem& fileSystem, const QString& inDir,
+                              const QString& author, const QString& credit, const QString& license)
 {
 	// Add missing "Introduction" heading if we have a headingless intro text
-	if(!markdown.contains(QRegularExpression("^\\s*# [^\n]+\n+\\s*##\\s*Introduction\n")))
-		markdown.replace(QRegularExpression("^(\\s*# [^\n]+\n+)(\\s*[^#])"), "\\1## Introduction\n\n\\2");
+	if(!Regex::get(Regex::IntroductionAfterTitle).matches(markdown))
+		Regex::get(Regex::TextAfterTitle).replaceIn(markdown, "\\1## Introduction\n\n\\2");
 	if(!markdown.contains("\n## Description\n"))
-	   markdown.replace(QRegularExpression("(\n## Introduction\n[^#]+\n)(\\s*#)"), "\\1## Description\n\n\\2");
+	   Regex::get(Regex::IntroductionWithoutDescription).replaceIn(markdown, "\\1## Description\n\n\\2");
 
 	// Add some sections the info for which is contained in info.ini in the old format
-	if(markdown.contains(QRegularExpression("\n##\\s+(?:References|External\\s+links)\\s*\n")))
-		markdown.replace(QRegularExpression("(\n##[ \t]+)External[ \t]+links([ \t]*\n)"), "\\1References\\2");
-	auto referencesFromFile = readReferencesFile(inDir);
+	if(Regex::get(Regex::ReferencesHeading).matches(markdown))
+		Regex::get(Regex::ExternalLinksHeading).replaceIn(markdown, "\\1References\\2");
+	auto referencesFromFile = readReferencesFile(fileSystem, inDir);
 
-	if(markdown.contains(QRegularExpression("\n##\\s+Authors?\\s*\n")))
+	if(Regex::get(Regex::AuthorsHeading).matches(markdown))
 	{
 		qWarning() << "Authors section already exists, not adding the authors from info.ini";
 
 		// But do add references before this section
 		if(!referencesFromFile.isEmpty())
-			markdown.replace(QRegularExpression("(\n##\\s+Authors?\\s*\n)"), "\n"+referencesFromFile + "\n\\1");
+			Regex::get(Regex::AuthorsHeading).replaceIn(markdown, "\n"+referencesFromFile + "\n\\1");
 	}
 	else
 	{
@@ -768,7 +819,7 @@ void addMissingTextToMarkdown(QString& markdown, const QString& inDir, const QSt
 			markdown += "\n## Authors\n\nAuthor is " + author + ". Additional credit goes to " + credit + "\n";
 	}
 
-	if(markdown.contains(QRegularExpression("\n##\\s+License\\s*\n")))
+	if(Regex::get(Regex::LicenseHeading).matches(markdown))
 		qWarning() << "License section already exists, not adding the license from info.ini";
 	else
 		markdown += "\n## License\n\n" + license + "\n";
@@ -784,13 +835,39 @@ struct Section
 	int headerStartPos = -1; // including #..#
 	int bodyStartPos = -1;
 	QString title;
-	QString body;
+	QStringView body; // points into the Markdown passed to splitToSections()
 	std::deque<int> subsections;
 };
 
+// Strips the leading newlines and trailing whitespace of a section body. Like the \s of the regex
+// this used to be done with, only ASCII whitespace is stripped: e.g. U+00A0 or U+3000 is kept.
+QStringView trimmedSectionBody(QStringView body)
+{
+	const auto isAsciiSpace = [](const QChar c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+	};
+	qsizetype start = 0;
+	while(start < body.size() && body[start] == '\n')
+		++start;
+	qsizetype end = body.size();
+	while(end > start && isAsciiSpace(body[end - 1]))
+		--end;
+	return body.sliced(start, end - start);
+}
+
+// Lists the levels and titles of the sections, one per line, for the diagnostics about mismatching translations
+QString sectionOutline(const std::vector<Section>& sections)
+{
+	QString outline;
+	for(const auto& sec : sections)
+		outline += QString("\n%1: %2").arg(sec.level).arg(sec.title);
+	return outline;
+}
+
 std::vector<Section> splitToSections(const QString& markdown)
 {
-	const QRegularExpression sectionHeaderPattern("^[ \t]*((#+)\\s+(.*[^\\s])\\s*)$", QRegularExpression::MultilineOption);
+	const auto& sectionHeaderPattern = Regex::get(Regex::SectionHeader);
 	std::vector<Section> sections;
 	for(auto matches = sectionHeaderPattern.globalMatch(markdown); matches.hasNext(); )
 	{
@@ -809,12 +886,9 @@ std::vector<Section> splitToSections(const QString& markdown)
 
 	for(unsigned n = 0; n < sections.size(); ++n)
 	{
-		if(n+1 < sections.size())
-			sections[n].body = markdown.mid(sections[n].bodyStartPos,
-			                                std::max(0, sections[n+1].headerLineStartPos - sections[n].bodyStartPos))
-			                           .replace(QRegularExpression("^\n*|\\s*$"), "");
-		else
-			sections[n].body = markdown.mid(sections[n].bodyStartPos).replace(QRegularExpression("^\n*|\\s*$"), "");
+		const qsizetype bodyStart = std::min<qsizetype>(sections[n].bodyStartPos, markdown.size());
+		const qsizetype bodyEnd = n+1 < sections.size() ? sections[n+1].headerLineStartPos : markdown.size();
+		sections[n].body = trimmedSectionBody(QStringView(markdown).sliced(bodyStart, std::max<qsizetype>(0, bodyEnd - bodyStart)));
 	}
 
 	return sections;
@@ -850,6 +924,134 @@ void gettextpo_xerror2(int severity,
 	if(severity == PO_SEVERITY_FATAL_ERROR)
 		std::abort();
 }
+
+// The parts of a stellarium-skycultures catalog used for the translations of names. The catalog
+// covers all the sky cultures, so its messages are grouped by the sky culture they refer to.
+struct NameCatalog
+{
+	struct Reference
+	{
+		QString msgid;
+		QString msgstr;
+		std::string file; // as in the source reference, e.g. "skycultures/western/star_names.fab"
+	};
+	std::optional<QString> header;
+	// A message is listed once per its reference to a file of the sky culture, in the order of the catalog
+	std::unordered_map<std::string/*culture ID*/, std::vector<Reference>> references;
+};
+
+std::shared_ptr<const NameCatalog> readNameCatalog(const QString& poFilePath)
+{
+	po_xerror_handler handler = {gettextpo_xerror, gettextpo_xerror2};
+	const auto file = po_file_read(poFilePath.toStdString().c_str(), &handler);
+	if(!file) return nullptr;
+
+	auto catalog = std::make_shared<NameCatalog>();
+	if(const auto header = po_file_domain_header(file, nullptr))
+		catalog->header = header;
+
+	const std::string_view prefix = "skycultures/";
+	const auto domains = po_file_domains(file);
+	for(auto domainp = domains; *domainp; domainp++)
+	{
+		po_message_iterator_t iterator = po_message_iterator(file, *domainp);
+		for(auto message = po_next_message(iterator); message != nullptr; message = po_next_message(iterator))
+		{
+			for(int n = 0; ; ++n)
+			{
+				const auto filepos = po_message_filepos(message, n);
+				if(!filepos) break;
+				const std::string_view refFileName = po_filepos_file(filepos);
+				if(!refFileName.starts_with(prefix)) continue;
+				const auto slash = refFileName.find('/', prefix.size());
+				if(slash == std::string_view::npos) continue;
+				catalog->references[std::string(refFileName.substr(prefix.size(), slash - prefix.size()))]
+					.push_back({po_message_msgid(message), po_message_msgstr(message), std::string(refFileName)});
+			}
+		}
+		po_message_iterator_free(iterator);
+	}
+	po_file_free(file);
+	return catalog;
+}
+}
+
+auto DescriptionOldLoader::EntryFingerprint::of(const std::set<QString>& comment, const QString& english) -> EntryFingerprint
+{
+	QCryptographicHash hash(QCryptographicHash::Blake2b_160);
+	// Prefix every string with its length so that different splits can't produce the same input
+	const auto addString = [&hash](const QString& str)
+	{
+		const qint64 size = str.size();
+		hash.addData(QByteArrayView(reinterpret_cast<const char*>(&size), sizeof size));
+		hash.addData(QByteArrayView(reinterpret_cast<const char*>(str.utf16()), str.size() * sizeof(char16_t)));
+	};
+	const qint64 commentCount = comment.size();
+	hash.addData(QByteArrayView(reinterpret_cast<const char*>(&commentCount), sizeof commentCount));
+	for(const auto& c : comment)
+		addString(c);
+	addString(english);
+
+	const auto digest = hash.result();
+	EntryFingerprint fp;
+	std::memcpy(&fp.high, digest.data(), sizeof fp.high);
+	std::memcpy(&fp.low, digest.data() + sizeof fp.high, sizeof fp.low);
+	return fp;
+}
+
+void appendSubsection(QString& markdown, const int level, const QString& title, const QStringView body)
+{
+	markdown += "\n\n";
+	markdown += QString(level, QChar('#'));
+	markdown += ' ';
+	markdown += title;
+	markdown += "\n\n";
+	markdown += body;
+	// The sections used to be cleaned up after each subsection, and QString::trimmed() stripped
+	// any trailing whitespace then, not only the ASCII one that trimmedSectionBody() strips
+	qsizetype end = markdown.size();
+	while(end > 0 && markdown[end - 1].isSpace())
+		--end;
+	markdown.truncate(end);
+}
+
+QByteArray tidyDescriptionHTML(const QByteArray& html)
+{
+	QByteArray xhtml;
+	if(!tidyHTML(html, xhtml))
+		return {};
+	// Detach from the buffer of the TidyDoc, which the next call reuses
+	return QByteArray(xhtml.constData(), xhtml.size());
+}
+
+QString convertXHTMLToMarkdownWithDOM(const QByteArray& xhtml, const bool footnotesToRefs)
+{
+	QDomDocument dom;
+	dom.setContent(xhtml);
+
+	QDomNode n;
+	bool bodyFound = false;
+	for(n = dom.firstChild(); !n.isNull(); n = n.nextSibling())
+	{
+		if(n.isElement() && n.toElement().tagName() == "html")
+			for(n = n.firstChild(); !n.isNull(); n = n.nextSibling())
+				if(n.isElement() && n.toElement().tagName() == "body")
+				{
+					bodyFound = true;
+					goto afterBodyFound;
+				}
+	}
+	if(!bodyFound)
+	{
+		Diagnostics::error("html-structure", "Failed to find HTML <body> tag in tidied HTML");
+		return {};
+	}
+afterBodyFound:
+
+	QString markdown;
+	bool h1emitted = false;
+	processHTMLNode(n, false, footnotesToRefs, h1emitted, markdown);
+	return markdown;
 }
 
 QString DescriptionOldLoader::translateSection(const QString& markdown, const qsizetype bodyStartPos,
@@ -857,31 +1059,63 @@ QString DescriptionOldLoader::translateSection(const QString& markdown, const qs
 {
 	const auto comment = QString("Sky culture %1 section in markdown format").arg(sectionName.trimmed().toLower());
 	auto text = markdown.mid(bodyStartPos, bodyEndPos - bodyStartPos);
-	text.replace(QRegularExpression("^\n*|\n*$"), "");
-	allMarkdownSections.insert(DictEntry{.comment = {comment}, .english = text, .translated = ""});
-	for(const auto& entry : translations[locale])
+	Regex::get(Regex::SurroundingNewlines).replaceIn(text, "");
+	DictEntry section{.comment = {comment}, .english = text, .translated = ""};
+	if(const auto fp = EntryFingerprint::of(section); !allMarkdownSectionFingerprints.contains(fp))
 	{
-		if(entry.english == text)
-		{
-			text = stripComments(entry.translated);
-			break;
-		}
-		if(entry.comment.find(comment) != entry.comment.end())
+		allMarkdownSectionFingerprints.insert(fp);
+		allMarkdownSections.push_back(std::move(section));
+	}
+
+	const auto dictIt = translations.constFind(locale);
+	const auto indexIt = translationIndices.constFind(locale);
+	if(dictIt == translations.cend() || indexIt == translationIndices.cend())
+		return text;
+	const auto& dict = dictIt.value();
+	const auto& index = indexIt.value();
+
+	const auto found = index.byEnglish.constFind(text);
+	const qsizetype matchPos = found == index.byEnglish.cend() ? qsizetype(dict.size()) : found.value();
+	// Entries for this section preceding the matching one must have been made for a different English text
+	if(const auto it = index.byComment.constFind(comment); it != index.byComment.cend())
+	{
+		for(const auto pos : it.value())
 		{
+			if(pos >= matchPos) break;
 			qWarning() << " *** BAD TRANSLATION ENTRY for section" << sectionName << "in locale" << locale;
-			qWarning() << "  Entry msgid:" << entry.english;
+			qWarning() << "  Entry msgid:" << dict[pos].english;
 			qWarning() << "  English section text:" << text << "\n";
-			continue;
 		}
 	}
+	if(matchPos < qsizetype(dict.size()))
+		text = stripComments(dict[matchPos].translated);
 	return text;
 }
 
+void DescriptionOldLoader::indexTranslations()
+{
+	translationIndices.clear();
+	for(auto it = translations.cbegin(); it != translations.cend(); ++it)
+	{
+		const auto& dict = it.value();
+		auto& index = translationIndices[it.key()];
+		index.byEnglish.reserve(dict.size());
+		for(qsizetype n = 0; n < qsizetype(dict.size()); ++n)
+		{
+			const auto& entry = dict[n];
+			if(!index.byEnglish.contains(entry.english))
+				index.byEnglish.insert(entry.english, n);
+			for(const auto& comment : entry.comment)
+				index.byComment[comment].push_back(n);
+		}
+	}
+}
+
 QString DescriptionOldLoader::translateDescription(const QString& markdownInput, const QString& locale)
 {
 	const auto markdown = stripComments(markdownInput);
 
-	const QRegularExpression headerPat("^# +(.+)$", QRegularExpression::MultilineOption);
+	const auto& headerPat = Regex::get(Regex::Level1Heading);
 	const auto match = headerPat.match(markdown);
 	QString name;
 	if (match.isValid())
@@ -895,7 +1129,7 @@ QString DescriptionOldLoader::translateDescription(const QString& markdownInput,
 	}
 
 	QString text = "# " + name + "\n\n";
-	const QRegularExpression sectionNamePat("^## +(.+)$", QRegularExpression::MultilineOption);
+	const auto& sectionNamePat = Regex::get(Regex::Level2Heading);
 	QString prevSectionName;
 	qsizetype prevBodyStartPos = -1;
 	for (auto it = sectionNamePat.globalMatch(markdown); it.hasNext(); )
@@ -930,123 +1164,92 @@ QString DescriptionOldLoader::translateDescription(const QString& markdownInput,
 void DescriptionOldLoader::addUntranslatedNames(const QString scName, const ConstellationOldLoader& consLoader,
                                                 const AsterismOldLoader& astLoader, const NamesOldLoader& namesLoader)
 {
-	for(auto& dict : translations)
+	// The names and their comments are the same for all the locales, so collect them once
+	TranslationDict catalog;
+	QHash<QString/*msgid*/, qsizetype/*position in catalog*/> catalogPositions;
+	const auto addName = [&catalog, &catalogPositions](const QString& englishName, QString&& comments)
 	{
-		std::set<QString> translated;
-		for(const auto& entry : dict)
-			translated.insert(entry.english);
-		std::map<QString/*msgid*/,unsigned/*position in dict*/> emittedNames;
-		for(const auto& cons : consLoader)
+		if(const auto it = catalogPositions.constFind(englishName); it != catalogPositions.cend())
 		{
-			if(cons.englishName.isEmpty())
-				continue;
-			if(translated.find(cons.englishName) != translated.end())
-				continue;
-			QString comments = scName+" constellation";
-			if(!cons.nativeName.isEmpty())
-				comments += ", native: "+cons.nativeName;
-			comments += '\n' + cons.translatorsComments;
-			if(const auto it = emittedNames.find(cons.englishName); it == emittedNames.end())
-			{
-				emittedNames[cons.englishName] = dict.size();
-				dict.push_back({{comments}, cons.englishName, ""});
-			}
-			else
-			{
-				auto& entry = dict[it->second];
-				entry.comment.insert(comments);
-			}
+			catalog[it.value()].comment.insert(std::move(comments));
 		}
-		for(const auto& ast : astLoader)
+		else
 		{
-			if(ast->getEnglishName().isEmpty())
-				continue;
-			if(translated.find(ast->getEnglishName()) != translated.end())
-				continue;
-			QString comments = scName+" asterism";
-			comments += '\n' + ast->getTranslatorsComments();
-			if(const auto it = emittedNames.find(ast->getEnglishName()); it == emittedNames.end())
-			{
-				emittedNames[ast->getEnglishName()] = dict.size();
-				dict.push_back({{comments}, ast->getEnglishName(), ""});
-			}
+			catalogPositions.insert(englishName, catalog.size());
+			catalog.push_back({{std::move(comments)}, englishName, ""});
+		}
+	};
+
+	for(const auto& cons : consLoader)
+	{
+		if(cons.englishName.isEmpty())
+			continue;
+		QString comments = scName+" constellation";
+		if(!cons.nativeName.isEmpty())
+			comments += ", native: "+cons.nativeName;
+		comments += '\n' + cons.translatorsComments;
+		addName(cons.englishName, std::move(comments));
+	}
+	for(const auto& ast : astLoader)
+	{
+		if(ast->getEnglishName().isEmpty())
+			continue;
+		QString comments = scName+" asterism";
+		comments += '\n' + ast->getTranslatorsComments();
+		addName(ast->getEnglishName(), std::move(comments));
+	}
+	for(auto it = namesLoader.starsBegin(); it != namesLoader.starsEnd(); ++it)
+	{
+		for(const auto& star : it.value())
+		{
+			QString comments;
+			if(star.nativeName.isEmpty())
+				comments = QString("%1 name for HIP %2").arg(scName).arg(star.HIP);
 			else
-			{
-				auto& entry = dict[it->second];
-				entry.comment.insert(comments);
-			}
+				comments = QString("%1 name for HIP %2, native: %3").arg(scName).arg(star.HIP).arg(star.nativeName);
+			comments += '\n' + star.translatorsComments;
+			addName(star.englishName, std::move(comments));
 		}
-		for(auto it = namesLoader.starsBegin(); it != namesLoader.starsEnd(); ++it)
+	}
+	for(auto it = namesLoader.planetsBegin(); it != namesLoader.planetsEnd(); ++it)
+	{
+		for(const auto& planet : it.value())
 		{
-			for(const auto& star : it.value())
-			{
-				if(translated.find(star.englishName) != translated.end())
-					continue;
-				QString comments;
-				if(star.nativeName.isEmpty())
-					comments = QString("%1 name for HIP %2").arg(scName).arg(star.HIP);
-				else
-					comments = QString("%1 name for HIP %2, native: %3").arg(scName).arg(star.HIP).arg(star.nativeName);
-				comments += '\n' + star.translatorsComments;
-				if(const auto it = emittedNames.find(star.englishName); it == emittedNames.end())
-				{
-					emittedNames[star.englishName] = dict.size();
-					dict.push_back({{comments}, star.englishName, ""});
-				}
-				else
-				{
-					auto& entry = dict[it->second];
-					entry.comment.insert(comments);
-				}
-			}
+			QString comments;
+			if(planet.native.isEmpty())
+				comments = QString("%1 name for NAME %2").arg(scName).arg(planet.id);
+			else
+				comments = QString("%1 name for NAME %2, native: %3").arg(scName).arg(planet.id, planet.native);
+			comments += '\n' + planet.translatorsComments;
+			addName(planet.english, std::move(comments));
 		}
-		for(auto it = namesLoader.planetsBegin(); it != namesLoader.planetsEnd(); ++it)
+	}
+	for(auto it = namesLoader.dsosBegin(); it != namesLoader.dsosEnd(); ++it)
+	{
+		for(const auto& dso : it.value())
 		{
-			for(const auto& planet : it.value())
-			{
-				if(translated.find(planet.english) != translated.end())
-					continue;
-				QString comments;
-				if(planet.native.isEmpty())
-					comments = QString("%1 name for NAME %2").arg(scName).arg(planet.id);
-				else
-					comments = QString("%1 name for NAME %2, native: %3").arg(scName).arg(planet.id, planet.native);
-				comments += '\n' + planet.translatorsComments;
-				if(const auto it = emittedNames.find(planet.english); it == emittedNames.end())
-				{
-					emittedNames[planet.english] = dict.size();
-					dict.push_back({{comments}, planet.english, ""});
-				}
-				else
-				{
-					auto& entry = dict[it->second];
-					entry.comment.insert(comments);
-				}
-			}
+			QString comments;
+			if(dso.nativeName.isEmpty())
+				comments = QString("%1 name for NAME %2").arg(scName).arg(dso.id);
+			else
+				comments = QString("%1 name for NAME %2, native: %3").arg(scName).arg(dso.id, dso.nativeName);
+			comments += '\n' + dso.translatorsComments;
+			addName(dso.englishName, std::move(comments));
 		}
-		for(auto it = namesLoader.dsosBegin(); it != namesLoader.dsosEnd(); ++it)
+	}
+
+	// Each locale only lacks the names it doesn't have translations for
+	for(auto& dict : translations)
+	{
+		QSet<QString> translated;
+		translated.reserve(dict.size());
+		for(const auto& entry : dict)
+			translated.insert(entry.english);
+		dict.reserve(dict.size() + catalog.size());
+		for(const auto& entry : catalog)
 		{
-			for(const auto& dso : it.value())
-			{
-				if(translated.find(dso.englishName) != translated.end())
-					continue;
-				QString comments;
-				if(dso.nativeName.isEmpty())
-					comments = QString("%1 name for NAME %2").arg(scName).arg(dso.id);
-				else
-					comments = QString("%1 name for NAME %2, native: %3").arg(scName).arg(dso.id, dso.nativeName);
-				comments += '\n' + dso.translatorsComments;
-				if(const auto it = emittedNames.find(dso.englishName); it == emittedNames.end())
-				{
-					emittedNames[dso.englishName] = dict.size();
-					dict.push_back({{comments}, dso.englishName, ""});
-				}
-				else
-				{
-					auto& entry = dict[it->second];
-					entry.comment.insert(comments);
-				}
-			}
+			if(!translated.contains(entry.english))
+				dict.push_back(entry);
 		}
 	}
 }
@@ -1055,50 +1258,47 @@ void DescriptionOldLoader::loadTranslationsOfNames(const QString& poBaseDir, con
                                                    const ConstellationOldLoader& consLoader, const AsterismOldLoader& astLoader,
                                                    const NamesOldLoader& namesLoader)
 {
-	po_xerror_handler handler = {gettextpo_xerror, gettextpo_xerror2};
 	const auto cultureId = cultureIdQS.toStdString();
 
 	const auto poDir = poBaseDir+"/stellarium-skycultures";
 	if(!poBaseDir.isEmpty() && !QFile(poDir).exists())
 		qWarning() << "Warning: no such directory" << poDir << "- will not load existing translations of names.";
-	for(const auto& fileName : QDir(poDir).entryList({"*.po"}))
+	const auto poFiles = QDir(poDir).entryList({"*.po"});
+	for(int n = 0; n < poFiles.size(); ++n)
 	{
+		if(progress->cancelled()) return;
+		const auto& fileName = poFiles[n];
+		progress->report("translations", fileName, n, poFiles.size());
 		const QString locale = fileName.chopped(3);
-		const auto file = po_file_read((poDir+"/"+fileName).toStdString().c_str(), &handler);
-		if(!file) continue;
+		// The catalogs are shared by all sky cultures, so they are parsed once per context
+		const auto catalogPath = poDir+"/"+fileName;
+		const auto catalog = context ? context->cachedFile<NameCatalog>(catalogPath, readNameCatalog)
+		                             : readNameCatalog(catalogPath);
+		if(!catalog) continue;
 
-		const auto header = po_file_domain_header(file, nullptr);
-		if(header) poHeaders[locale] = header;
+		if(catalog->header) poHeaders[locale] = *catalog->header;
 
 		qDebug().nospace() << "Processing translations of names for locale " << locale << "...";
 		auto& dict = translations[locale];
 		std::unordered_map<QString/*msgid*/,int/*position*/> insertedNames;
 
 		// First try to find translation for the name of the sky culture
+		// The catalog is large and shared by all sky cultures, so only its "sky culture" messages are
+		// extracted, once per context. They are cached under the name of their context, which keeps them
+		// apart from the messages of other contexts extracted from the same files.
 		bool scNameTranslated = false;
-		if(const auto scNameFile = po_file_read((poBaseDir+"/stellarium/"+fileName).toStdString().c_str(), &handler))
+		const QString scNamesContext = "sky culture";
+		const auto readSkyCultureNames = [&scNamesContext](const QString& path) { return PoUtils::contextTranslations(path, scNamesContext.toUtf8()); };
+		const auto scNamesPath = poBaseDir+"/stellarium/"+fileName;
+		const auto scNames = context ? context->cachedFile<PoUtils::Translations>(scNamesPath, scNamesContext, readSkyCultureNames)
+		                             : readSkyCultureNames(scNamesPath);
+		if(scNames)
 		{
-			const auto domains = po_file_domains(scNameFile);
-			for(auto domainp = domains; *domainp && !scNameTranslated; domainp++)
+			if(const auto it = scNames->constFind(englishName); it != scNames->cend())
 			{
-				const auto domain = *domainp;
-				po_message_iterator_t iterator = po_message_iterator(scNameFile, domain);
-
-				for(auto message = po_next_message(iterator); message != nullptr; message = po_next_message(iterator))
-				{
-					const auto msgid = po_message_msgid(message);
-					const auto msgstr = po_message_msgstr(message);
-					const auto ctxt = po_message_msgctxt(message);
-					if(ctxt && ctxt == std::string_view("sky culture") && msgid == englishName)
-					{
-						dict.insert(dict.begin(), {{"Sky culture name"}, msgid, msgstr});
-						scNameTranslated = true;
-						break;
-					}
-				}
-				po_message_iterator_free(iterator);
+				dict.insert(dict.begin(), {{"Sky culture name"}, englishName, it.value()});
+				scNameTranslated = true;
 			}
-			po_file_free(scNameFile);
 		}
 
 		if(!scNameTranslated)
@@ -1111,133 +1311,206 @@ void DescriptionOldLoader::loadTranslationsOfNames(const QString& poBaseDir, con
 			{"skycultures/"+cultureId+"/asterism_names.eng.fab", "asterism"},
 			{"skycultures/"+cultureId+"/constellation_names.eng.fab", "constellation"},
 		};
-		QString comments;
-		const auto domains = po_file_domains(file);
-		for(auto domainp = domains; *domainp; domainp++)
+		const auto refs = catalog->references.find(cultureId);
+		if(refs == catalog->references.end()) continue;
+		for(const auto& reference : refs->second)
 		{
-			const auto domain = *domainp;
-			po_message_iterator_t iterator = po_message_iterator(file, domain);
-
-			for(auto message = po_next_message(iterator); message != nullptr; message = po_next_message(iterator))
+			const auto& msgid = reference.msgid;
+			const auto& msgstr = reference.msgstr;
+			QString comments;
+			const auto ref = sourceFiles.find(reference.file);
+			if(ref == sourceFiles.end()) continue;
+			const auto type = ref->second;
+			if(type == "constellation")
 			{
-				const auto msgid = po_message_msgid(message);
-				const auto msgstr = po_message_msgstr(message);
-				QString comments = po_message_extracted_comments(message);
-				for(int n = 0; ; ++n)
+				const auto cons = consLoader.find(msgid);
+				if(cons)
 				{
-					const auto filepos = po_message_filepos(message, n);
-					if(!filepos) break;
-					const auto refFileName = po_filepos_file(filepos);
-					const auto ref = sourceFiles.find(refFileName);
-					if(ref == sourceFiles.end()) continue;
-					const auto type = ref->second;
-					if(type == "constellation")
-					{
-						const auto cons = consLoader.find(msgid);
-						if(cons)
-						{
-							comments = englishName+" constellation";
-							if(!cons->nativeName.isEmpty())
-								comments += ", native: "+cons->nativeName;
-							comments += '\n' + cons->translatorsComments;
-						}
-						else
-						{
-							continue;
-						}
-					}
-					else if(type == "asterism")
-					{
-						if(const auto aster = astLoader.find(msgid))
-						{
-							comments = englishName+" asterism";
-							comments += '\n' + aster->getTranslatorsComments();
-						}
-						else
-						{
-							continue;
-						}
-					}
-					else if(type == "star")
-					{
-						const auto star = namesLoader.findStar(msgid);
-						if(star && star->HIP > 0)
-						{
-							if(star->nativeName.isEmpty())
-								comments = QString("%1 name for HIP %2").arg(englishName).arg(star->HIP);
-							else
-								comments = QString("%1 name for HIP %2, native: %3").arg(englishName).arg(star->HIP).arg(star->nativeName);
-							comments += '\n' + star->translatorsComments;
-						}
-						else
-						{
-							continue;
-						}
-					}
-					else if(type == "planet")
-					{
-						if(const auto planet = namesLoader.findPlanet(msgid))
-						{
-							if(planet->native.isEmpty())
-								comments = QString("%1 name for NAME %2").arg(englishName).arg(planet->id);
-							else
-								comments = QString("%1 name for NAME %2, native: %3").arg(englishName).arg(planet->id, planet->native);
-							comments += '\n' + planet->translatorsComments;
-						}
-						else
-						{
-							continue;
-						}
-					}
-					else if(type == "dso")
-					{
-						if(const auto dso = namesLoader.findDSO(msgid))
-						{
-							if(dso->nativeName.isEmpty())
-								comments = QString("%1 name for %2").arg(englishName).arg(dso->id);
-							else
-								comments = QString("%1 name for %2, native: %3").arg(englishName).arg(dso->id, dso->nativeName);
-							comments += '\n' + dso->translatorsComments;
-						}
-						else
-						{
-							continue;
-						}
-					}
-					if(const auto it = insertedNames.find(msgid); it != insertedNames.end())
-					{
-						auto& entry = dict[it->second];
-						entry.comment.insert(comments);
-						continue;
-					}
-					insertedNames[msgid] = dict.size();
-					dict.push_back({{comments}, msgid, msgstr});
+					comments = englishName+" constellation";
+					if(!cons->nativeName.isEmpty())
+						comments += ", native: "+cons->nativeName;
+					comments += '\n' + cons->translatorsComments;
+				}
+				else
+				{
+					continue;
+				}
+			}
+			else if(type == "asterism")
+			{
+				if(const auto aster = astLoader.find(msgid))
+				{
+					comments = englishName+" asterism";
+					comments += '\n' + aster->getTranslatorsComments();
+				}
+				else
+				{
+					continue;
+				}
+			}
+			else if(type == "star")
+			{
+				const auto star = namesLoader.findStar(msgid);
+				if(star && star->HIP > 0)
+				{
+					if(star->nativeName.isEmpty())
+						comments = QString("%1 name for HIP %2").arg(englishName).arg(star->HIP);
+					else
+						comments = QString("%1 name for HIP %2, native: %3").arg(englishName).arg(star->HIP).arg(star->nativeName);
+					comments += '\n' + star->translatorsComments;
+				}
+				else
+				{
+					continue;
+				}
+			}
+			else if(type == "planet")
+			{
+				if(const auto planet = namesLoader.findPlanet(msgid))
+				{
+					if(planet->native.isEmpty())
+						comments = QString("%1 name for NAME %2").arg(englishName).arg(planet->id);
+					else
+						comments = QString("%1 name for NAME %2, native: %3").arg(englishName).arg(planet->id, planet->native);
+					comments += '\n' + planet->translatorsComments;
+				}
+				else
+				{
+					continue;
+				}
+			}
+			else if(type == "dso")
+			{
+				if(const auto dso = namesLoader.findDSO(msgid))
+				{
+					if(dso->nativeName.isEmpty())
+						comments = QString("%1 name for %2").arg(englishName).arg(dso->id);
+					else
+						comments = QString("%1 name for %2, native: %3").arg(englishName).arg(dso->id, dso->nativeName);
+					comments += '\n' + dso->translatorsComments;
+				}
+				else
+				{
+					continue;
 				}
 			}
-			po_message_iterator_free(iterator);
+			if(const auto it = insertedNames.find(msgid); it != insertedNames.end())
+			{
+				auto& entry = dict[it->second];
+				entry.comment.insert(comments);
+				continue;
+			}
+			insertedNames[msgid] = dict.size();
+			dict.push_back({{comments}, msgid, msgstr});
 		}
-		po_file_free(file);
 	}
 	addUntranslatedNames(englishName, consLoader, astLoader, namesLoader);
 }
 
-void DescriptionOldLoader::locateAndRelocateAllInlineImages(QString& html, const bool saveToRefs)
+void DescriptionOldLoader::locateAndRelocateAllInlineImages(QByteArray& htmlUtf8, const bool saveToRefs)
 {
-	for(auto matches = htmlGeneralImageRegex.globalMatch(html); matches.hasNext(); )
+	// Most descriptions have no images, so don't decode them just to find that out
+	if(!htmlUtf8.contains("<img"))
+		return;
+
+	const auto html = QString::fromUtf8(htmlUtf8);
+	// Copy the document into a new buffer, rewriting the src attributes on the way
+	QString updatedHTML;
+	qsizetype copiedUpTo = 0;
+	for(auto matches = Regex::get(Regex::HTMLGeneralImage).globalMatch(html); matches.hasNext(); )
 	{
 		const auto& match = matches.next();
-		auto path = match.captured(1);
+		const auto path = match.captured(1);
 		auto updatedPath = path;
 		if(!path.startsWith("illustrations/"))
 		{
 			updatedPath = "illustrations/" + path;
-			const auto imgTag = match.captured(0);
-			const auto updatedImgTag = QString(imgTag).replace(path, updatedPath);
-			html.replace(imgTag, updatedImgTag);
+			if(updatedHTML.isEmpty())
+				updatedHTML.reserve(html.size() + 64);
+			const auto pathStart = match.capturedStart(1);
+			updatedHTML += QStringView(html).sliced(copiedUpTo, pathStart - copiedUpTo);
+			updatedHTML += updatedPath;
+			copiedUpTo = match.capturedEnd(1);
 		}
-		if(saveToRefs)
+		if(saveToRefs && !imageHRefInputPaths.contains(path))
+		{
+			imageHRefInputPaths.insert(path);
 			imageHRefs.emplace_back(path, updatedPath);
+		}
+	}
+	if(copiedUpTo == 0)
+		return;
+	updatedHTML += QStringView(html).sliced(copiedUpTo);
+	htmlUtf8 = updatedHTML.toUtf8();
+}
+
+QString DescriptionOldLoader::convertHTMLToMarkdownCached(QByteArray html, const bool footnotesToRefs) const
+{
+	if(markdownCacheDir.isEmpty())
+		return convertHTMLToMarkdown(std::move(html), footnotesToRefs);
+
+	// Bump this whenever a change in the conversion code changes its output
+	constexpr int converterVersion = 2;
+	QCryptographicHash hash(QCryptographicHash::Blake2b_256);
+	hash.addData(html);
+	// libtidy's output may differ between its versions, so it's part of the key too
+	hash.addData(QString(" footnotesToRefs=%1 v%2 tidy %3").arg(int(footnotesToRefs)).arg(converterVersion)
+	                                                        .arg(tidyLibraryVersion()).toUtf8());
+	// The logging filter rules stop the messages of the disabled levels before they are reported,
+	// so an entry only has the diagnostics of the levels that were enabled when it was filled
+	const auto logging = QLoggingCategory::defaultCategory();
+	hash.addData(QString(" debug=%1 info=%2").arg(int(logging->isDebugEnabled()))
+	                                         .arg(int(logging->isInfoEnabled())).toUtf8());
+	const auto cachePath = markdownCacheDir + "/" + QString::fromLatin1(hash.result().toHex()) + ".json";
+
+	// An entry holds the diagnostics of the conversion along with its result, and a hit reports
+	// them again, so that the output of the converter doesn't depend on the state of the cache.
+	const auto replay = [](const QJsonArray& diagnostics)
+	{
+		for(const auto& value : diagnostics)
+		{
+			const auto record = value.toObject();
+			auto severity = Diagnostics::Severity::Warning;
+			for(const auto s : {Diagnostics::Severity::Debug, Diagnostics::Severity::Info,
+			                    Diagnostics::Severity::Warning, Diagnostics::Severity::Error})
+				if(record["severity"].toString() == Diagnostics::severityName(s))
+					severity = s;
+			for(int n = 0; n < record["count"].toInt(1); ++n)
+				Diagnostics::report(severity, record["code"].toString(), record["message"].toString(),
+				                    record["file"].toString(), record["line"].toInt());
+		}
+	};
+	if(QFile cached(cachePath); cached.open(QFile::ReadOnly))
+	{
+		const auto entry = QJsonDocument::fromJson(cached.readAll()).object();
+		if(entry["markdown"].isString() && entry["diagnostics"].isArray())
+		{
+			replay(entry["diagnostics"].toArray());
+			return entry["markdown"].toString();
+		}
+	}
+
+	Diagnostics::Collector collector;
+	QString markdown;
+	{
+		auto context = Diagnostics::Context::current();
+		context.collector = &collector;
+		Diagnostics::Scope scope(context);
+		markdown = convertHTMLToMarkdown(std::move(html), footnotesToRefs);
 	}
+	const auto diagnostics = QJsonDocument::fromJson(collector.toJSON()).array();
+	replay(diagnostics);
+	if(markdown.isEmpty())
+		return markdown;
+
+	// The entries are replaced atomically, so concurrent conversions can share the cache. Failing
+	// to fill it is not an error, as it's only an optimization.
+	const auto data = QJsonDocument(QJsonObject{{"markdown", markdown}, {"diagnostics", diagnostics}}).toJson();
+	QSaveFile cacheFile(cachePath);
+	if(!QDir().mkpath(markdownCacheDir) || !cacheFile.open(QIODevice::WriteOnly) ||
+	   cacheFile.write(data) != data.size() || !cacheFile.commit())
+		qWarning().noquote() << "Failed to store" << cachePath << "in the Markdown cache";
+	return markdown;
 }
 
 void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir, const QString& cultureId, const QString& englishName,
@@ -1246,19 +1519,24 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
                                 const bool footnotesToRefs, const bool genTranslatedMD)
 {
 	inputDir = inDir;
+	const auto descriptionFiles = fileSystem->entryList(inDir, {"description.*.utf8"});
+	int descriptionsDone = 0;
 	const auto englishDescrPath = inDir+"/description.en.utf8";
-	QFile englishDescrFile(englishDescrPath);
-	if(!englishDescrFile.open(QFile::ReadOnly))
+	progress->report("description", "description.en.utf8", descriptionsDone++, descriptionFiles.size());
+	auto englishDescr = fileSystem->readAll(englishDescrPath);
+	if(!englishDescr)
 	{
 		qCritical().noquote() << "Failed to open file" << englishDescrPath;
 		return;
 	}
-	QString html = englishDescrFile.readAll();
+	QByteArray html = *std::move(englishDescr);
 	locateAndRelocateAllInlineImages(html, true);
 	qDebug() << "Processing English description...";
-	markdown = convertHTMLToMarkdown(html, footnotesToRefs);
+	markdown = convertHTMLToMarkdownCached(std::move(html), footnotesToRefs);
 
-	auto englishSections = splitToSections(markdown);
+	// The sections refer to this copy, since markdown gets rebuilt from them below
+	const QString englishMarkdown = markdown;
+	auto englishSections = splitToSections(englishMarkdown);
 	const int level1sectionCount = std::count_if(englishSections.begin(), englishSections.end(),
 	                                             [](auto& s){return s.level==1;});
 	if(level1sectionCount != 1)
@@ -1322,7 +1600,7 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
 		englishSections[0].title = englishName;
 	}
 
-	const QRegularExpression localePattern("description\\.([^.]+)\\.utf8");
+	const auto& localePattern = Regex::get(Regex::DescriptionLocale);
 
 	// This will contain the final form of the English sections for use as a key
 	// in translations as well as to reconstruct the main description.md
@@ -1339,9 +1617,12 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
 	}
 
 	std::vector<QString> locales;
-	for(const auto& fileName : QDir(inDir).entryList({"description.*.utf8"}))
+	for(const auto& fileName : descriptionFiles)
 	{
 		if(fileName == "description.en.utf8") continue;
+		// Tidying and converting a description is the slowest part, so check before each one
+		if(progress->cancelled()) return;
+		progress->report("description", fileName, descriptionsDone++, descriptionFiles.size());
 
 		const auto localeMatch = localePattern.match(fileName);
 		if(!localeMatch.isValid())
@@ -1352,32 +1633,27 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
 		const auto locale = localeMatch.captured(1);
 		locales.push_back(locale);
 		const auto path = inDir + "/" + fileName;
-		QFile file(path);
-		if(!file.open(QFile::ReadOnly))
+		auto localizedDescr = fileSystem->readAll(path);
+		if(!localizedDescr)
 		{
 			qCritical().noquote() << "Failed to open file" << path << "\n";
 			continue;
 		}
 		qDebug().nospace() << "Processing description for locale " << locale << "...";
-		QString localizedHTML = file.readAll();
+		QByteArray localizedHTML = *std::move(localizedDescr);
 		locateAndRelocateAllInlineImages(localizedHTML, false);
-		auto trMD0 = convertHTMLToMarkdown(localizedHTML, footnotesToRefs);
-		const auto translationMD = trMD0.replace(QRegularExpression("<notr>([^<]+)</notr>"), "\\1");
+		auto trMD0 = convertHTMLToMarkdownCached(std::move(localizedHTML), footnotesToRefs);
+		const auto translationMD = Regex::get(Regex::NotrElement).replaceIn(trMD0, "\\1");
 		const auto translatedSections = splitToSections(translationMD);
 		if(translatedSections.size() != englishSections.size())
 		{
-			qCritical().nospace().noquote() << "Number of sections (" << translatedSections.size()
-			                                << ") in description for locale " << locale
-			                                << " doesn't match that of the English description ("
-			                                << englishSections.size() << "). Skipping this translation.";
-			auto dbg = qDebug().nospace().noquote();
-			dbg << " ** English section titles:\n";
-			for(const auto& sec : englishSections)
-				dbg << sec.level << ": " << sec.title << "\n";
-			dbg << " ** Translated section titles:\n";
-			for(const auto& sec : translatedSections)
-				dbg << sec.level << ": " << sec.title << "\n";
-			dbg << "\n____________________________________________\n";
+			Diagnostics::error("section-mismatch",
+			                   QString("Number of sections (%1) in description for locale %2 doesn't match that of "
+			                           "the English description (%3). Skipping this translation.\n"
+			                           " ** English section titles:%4\n ** Translated section titles:%5")
+			                       .arg(translatedSections.size()).arg(locale).arg(englishSections.size())
+			                       .arg(sectionOutline(englishSections), sectionOutline(translatedSections)),
+			                   QDir::toNativeSeparators(path));
 			continue;
 		}
 
@@ -1386,16 +1662,12 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
 		{
 			if(translatedSections[n].level != englishSections[n].level)
 			{
-				qCritical() << "Section structure of English text and translation for"
-				            << locale << "doesn't match, skipping this translation";
-				auto dbg = qDebug().nospace();
-				dbg << " ** English section titles:\n";
-				for(const auto& sec : englishSections)
-					dbg << sec.level << ": " << sec.title << "\n";
-				dbg << " ** Translated section titles:\n";
-				for(const auto& sec : translatedSections)
-					dbg << sec.level << ": " << sec.title << "\n";
-				dbg << "\n____________________________________________\n";
+				Diagnostics::error("section-mismatch",
+				                   QString("Section structure of English text and translation for %1 doesn't match, "
+				                           "skipping this translation\n"
+				                           " ** English section titles:%2\n ** Translated section titles:%3")
+				                       .arg(locale, sectionOutline(englishSections), sectionOutline(translatedSections)),
+				                   QDir::toNativeSeparators(path));
 				sectionsOK = false;
 				break;
 			}
@@ -1408,8 +1680,8 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
 			const auto& engSec = englishSections[n];
 			if(engSec.level + engSec.levelAddition > 2) continue;
 
-			QString key = engSec.body;
-			QString value = translatedSections[n].body;
+			QString key = engSec.body.toString();
+			QString value = translatedSections[n].body.toString();
 			auto titleForComment = engSec.title.contains(' ') ? '"' + engSec.title.toLower() + '"' : engSec.title.toLower();
 			auto sectionTitle = engSec.title;
 			bool insertDescriptionHeading = false;
@@ -1428,29 +1700,23 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
 				insertDescriptionHeading = true;
 			}
 
+			// The subsections are appended first and cleaned up once: the cleanup only
+			// affects runs of whitespace and lists, which don't span the headings
 			for(const auto subN : engSec.subsections)
 			{
 				const auto& keySubSection = englishSections[subN];
-				key += "\n\n";
-				key += QString(keySubSection.level + keySubSection.levelAddition, QChar('#'));
-				key += ' ';
-				key += keySubSection.title;
-				key += "\n\n";
-				key += keySubSection.body;
-				key += "\n\n";
-				cleanupWhitespace(key);
-				key.replace(QRegularExpression("^\n*|\\s*$"), "");
-
 				const auto& valueSubSection = translatedSections[subN];
-				value += "\n\n";
-				value += QString(keySubSection.level + keySubSection.levelAddition, QChar('#'));
-				value += ' ';
-				value += valueSubSection.title;
-				value += "\n\n";
-				value += valueSubSection.body;
-				value += "\n\n";
+				const int level = keySubSection.level + keySubSection.levelAddition;
+				appendSubsection(key, level, keySubSection.title, keySubSection.body);
+				appendSubsection(value, level, valueSubSection.title, valueSubSection.body);
+			}
+			if(!engSec.subsections.empty())
+			{
+				// Drop the newline that cleanupWhitespace() leaves at the end
+				cleanupWhitespace(key);
+				key.chop(1);
 				cleanupWhitespace(value);
-				value.replace(QRegularExpression("^\n*|\\s*$"), "");
+				value.chop(1);
 			}
 			if(!finalEnglishSectionsDone)
 			{
@@ -1497,129 +1763,101 @@ void DescriptionOldLoader::load(const QString& inDir, const QString& poBaseDir,
 		}
 	}
 
-	addMissingTextToMarkdown(markdown, inDir, author, credit, license);
+	addMissingTextToMarkdown(markdown, *fileSystem, inDir, author, credit, license);
 	if(genTranslatedMD)
 	{
+		indexTranslations();
 		for(const auto& locale : locales)
 			translatedMDs[locale] = translateDescription(markdown, locale);
 	}
 
+	if(progress->cancelled()) return;
 	loadTranslationsOfNames(poBaseDir, cultureId, englishName, consLoader, astLoader, namesLoader);
 }
 
-bool DescriptionOldLoader::dumpMarkdown(const QString& outDir) const
+bool DescriptionOldLoader::dumpMarkdown(OutputDir& outDir) const
 {
-	const auto path = outDir+"/description.md";
-	QFile file(path);
-	if(!file.open(QFile::WriteOnly))
-	{
-		qCritical().noquote() << "Failed to open file" << path << "\n";
-		return false;
-	}
+	if(markdown.isEmpty())
+		return outDir.writeFile("description.md", {});
 
-	if(markdown.isEmpty()) return true;
-
-	if(file.write(markdown.toUtf8()) < 0 || !file.flush())
-	{
-		qCritical().noquote() << "Failed to write " << path << ": " << file.errorString() << "\n";
+	if(!outDir.writeFile("description.md", markdown.toUtf8()))
 		return false;
-	}
 
 	for(const auto& img : imageHRefs)
 	{
 		const auto imgInPath = inputDir+"/"+img.inputPath;
-		const auto imgInInfo = QFileInfo(imgInPath);
-		if(!imgInInfo.exists())
+		if(!fileSystem->exists(imgInPath))
 		{
 			qCritical() << "Failed to locate an image referenced in the description:" << img.inputPath;
 			continue;
 		}
-		const auto imgOutPath = outDir + "/" + img.outputPath;
-		const auto imgOutInfo = QFileInfo(imgOutPath);
-		bool targetExistsAndDiffers = imgOutInfo.exists() && imgInInfo.size() != imgOutInfo.size();
-		if(imgOutInfo.exists() && !targetExistsAndDiffers)
-		{
-			// Check that the contents are the same
-			QFile in(imgInPath);
-			if(!in.open(QFile::ReadOnly))
-			{
-				qCritical().noquote() << "Failed to open file" << imgInPath;
-				continue;
-			}
-			QFile out(imgOutPath);
-			if(!out.open(QFile::ReadOnly))
-			{
-				qCritical().noquote() << "Failed to open file" << imgOutPath;
-				continue;
-			}
-			targetExistsAndDiffers = in.readAll() != out.readAll();
-		}
-		if(targetExistsAndDiffers)
-		{
-			qCritical() << "Image file names collide:" << img.inputPath << "and" << img.outputPath;
-			continue;
-		}
-
-		if(imgOutInfo.exists())
-		{
-			// It exists, but is the same as the file we're trying to copy, so skip it
-			continue;
-		}
-
-		const auto imgDir = QFileInfo(imgOutPath).absoluteDir().absolutePath();
-		if(!QDir().mkpath(imgDir))
-		{
-			qCritical() << "Failed to create output directory for image file" << img.outputPath;
-			continue;
-		}
-
-		if(!QFile(imgInPath).copy(imgOutPath))
-		{
-			qCritical() << "Failed to copy an image file referenced in the description:" << img.inputPath << "to" << img.outputPath;
-			continue;
-		}
+		outDir.publishFileAsync(imgInPath, img.outputPath);
 	}
 
 	if(!translatedMDs.isEmpty())
 	{
-		for(const auto& key : translatedMDs.keys())
+		for(auto it = translatedMDs.begin(); it != translatedMDs.end(); ++it)
 		{
-			const auto path = outDir+"/description."+key+".DO_NOT_COMMIT.md";
-			QFile file(path);
-			if(!file.open(QFile::WriteOnly))
-			{
-				qCritical().noquote() << "Failed to open file" << path << "\n";
+			if(!outDir.writeFile("description."+it.key()+".DO_NOT_COMMIT.md", it.value().toUtf8()))
 				return false;
-			}
-			if(file.write(translatedMDs[key].toUtf8()) < 0 || !file.flush())
-			{
-				qCritical().noquote() << "Failed to write " << path << ": " << file.errorString() << "\n";
-				return false;
-			}
 		}
 	}
 
 	return true;
 }
 
-bool DescriptionOldLoader::dump(const QString& outDir) const
+bool DescriptionOldLoader::dump(OutputDir& outDir) const
 {
 	if(!dumpMarkdown(outDir)) return false;
 
-	const auto poDir = outDir + "/po";
-	if(!QDir().mkpath(poDir))
+	// libgettextpo can only write to files, so the .po files are serialized natively when in memory
+	const bool writeNatively = nativePoWriter || outDir.isInMemory();
+	const auto poDir = outDir.absolutePath("po");
+	if(!outDir.isInMemory() && !QDir().mkpath(poDir))
 	{
 		qCritical() << "Failed to create po directory\n";
 		return false;
 	}
 
+	// The sections are emitted in the same order into every file, so sort them only once
+	std::vector<std::pair<EntryFingerprint, const DictEntry*>> sortedMarkdownSections;
+	sortedMarkdownSections.reserve(allMarkdownSections.size());
+	for(const auto& entry : allMarkdownSections)
+		sortedMarkdownSections.emplace_back(EntryFingerprint::of(entry), &entry);
+	std::sort(sortedMarkdownSections.begin(), sortedMarkdownSections.end(),
+	          [](const auto& a, const auto& b) { return *a.second < *b.second; });
+
+	int localesDone = 0;
 	for(auto dictIt = translations.begin(); dictIt != translations.end(); ++dictIt)
 	{
+		if(progress->cancelled()) return false;
 		const auto& locale = dictIt.key();
-		const auto path = poDir + "/" + locale + ".po";
-
-		const auto file = po_file_create();
-		po_message_iterator_t iterator = po_message_iterator(file, nullptr);
+		progress->report("output", locale + ".po", localesDone++, translations.size());
+		const auto relPath = "po/" + locale + ".po";
+		const auto path = outDir.absolutePath(relPath);
+
+		PoUtils::PoWriter nativeWriter;
+		po_file_t file = nullptr;
+		po_message_iterator_t iterator = nullptr;
+		if(!writeNatively)
+		{
+			file = po_file_create();
+			iterator = po_message_iterator(file, nullptr);
+		}
+		const auto addMessage = [&](const std::set<QString>& comment, const QString& msgid, const QString& msgstr)
+		{
+			if(writeNatively)
+			{
+				nativeWriter.addMessage(msgid, msgstr, comment.empty() ? QString() : join(comment));
+				return;
+			}
+			const auto msg = po_message_create();
+			if(!comment.empty())
+				po_message_set_extracted_comments(msg, join(comment).toStdString().c_str());
+			po_message_set_msgid(msg, msgid.toStdString().c_str());
+			po_message_set_msgstr(msg, msgstr.toStdString().c_str());
+			po_message_insert(iterator, msg);
+		};
 
 		// I've found no API to *create* a header, so will try to emulate it with a message
 		const auto headerIt = poHeaders.find(locale);
@@ -1632,43 +1870,42 @@ bool DescriptionOldLoader::dump(const QString& outDir) const
 		const QString header = headerIt == poHeaders.end() ?
 			defaultHeaderTemplate.arg(locale) :
 			headerIt.value();
-		const auto headerMsg = po_message_create();
-		po_message_set_msgid(headerMsg, "");
-		po_message_set_msgstr(headerMsg, header.toStdString().c_str());
-		po_message_insert(iterator, headerMsg);
+		addMessage({}, "", header);
 
-		std::set<DictEntry> emittedEntries;
+		QSet<EntryFingerprint> emittedEntries;
+		emittedEntries.reserve(dictIt.value().size() + sortedMarkdownSections.size());
 		for(const auto& entry : dictIt.value())
 		{
-			const DictEntry untransEntry{.comment = entry.comment, .english = entry.english, .translated = ""};
-			if(emittedEntries.find(untransEntry) != emittedEntries.end()) continue;
-			const auto msg = po_message_create();
-			if(!entry.comment.empty())
-				po_message_set_extracted_comments(msg, join(entry.comment).toStdString().c_str());
-			po_message_set_msgid(msg, entry.english.toStdString().c_str());
-			po_message_set_msgstr(msg, entry.translated.toStdString().c_str());
-			po_message_insert(iterator, msg);
-			emittedEntries.insert(untransEntry);
+			const auto fp = EntryFingerprint::of(entry);
+			if(emittedEntries.contains(fp)) continue;
+			addMessage(entry.comment, entry.english, entry.translated);
+			emittedEntries.insert(fp);
 		}
 
 		// Add untranslated markdown entries
-		for(const auto& entry : allMarkdownSections)
+		for(const auto& [fp, entry] : sortedMarkdownSections)
 		{
-			if(const auto found = emittedEntries.find(entry); found == emittedEntries.end())
+			if(!emittedEntries.contains(fp))
 			{
-				const auto msg = po_message_create();
-				po_message_set_msgid(msg, entry.english.toStdString().c_str());
-				if(!entry.comment.empty())
-					po_message_set_extracted_comments(msg, join(entry.comment).toStdString().c_str());
-				po_message_insert(iterator, msg);
-				emittedEntries.insert(entry);
+				addMessage(entry->comment, entry->english, "");
+				emittedEntries.insert(fp);
 			}
 		}
 
+		if(writeNatively)
+		{
+			if(!outDir.writeFile(relPath, nativeWriter.data()))
+				return false;
+			continue;
+		}
+
 		po_message_iterator_free(iterator);
 		po_xerror_handler handler = {gettextpo_xerror, gettextpo_xerror2};
 		po_file_write(file, path.toStdString().c_str(), &handler);
 		po_file_free(file);
+		// libgettextpo writes the file by itself, so we can only hash it afterwards
+		if(!outDir.addExistingFile(relPath))
+			return false;
 	}
 	return true;
 }
@@ -23,8 +23,14 @@
 #include <tuple>
 #include <vector>
 #include <QHash>
+#include <QSet>
+#include <QByteArray>
 #include <QString>
+#include "FileSystem.hpp"
+#include "Progress.hpp"
 
+class OutputDir;
+class ConverterContext;
 class ConstellationOldLoader;
 class AsterismOldLoader;
 class NamesOldLoader;
@@ -42,6 +48,7 @@ class DescriptionOldLoader
 		QString outputPath;
 	};
 	std::vector<ImageHRef> imageHRefs;
+	QSet<QString> imageHRefInputPaths; // to publish each image once however many times it is shown
 	struct DictEntry
 	{
 		std::set<QString> comment;
@@ -53,20 +60,70 @@ class DescriptionOldLoader
 		}
 	};
 	using TranslationDict = std::vector<DictEntry>;
+	// Identifies a PO message by its comments and msgid, to dedupe entries without comparing whole sections
+	struct EntryFingerprint
+	{
+		quint64 high = 0, low = 0;
+		static EntryFingerprint of(const std::set<QString>& comment, const QString& english);
+		static EntryFingerprint of(const DictEntry& entry) { return of(entry.comment, entry.english); }
+		bool operator==(const EntryFingerprint&) const = default;
+		friend size_t qHash(const EntryFingerprint& fp, const size_t seed = 0) noexcept
+		{
+			return qHashMulti(seed, fp.high, fp.low);
+		}
+	};
 	QHash<QString/*locale*/, TranslationDict> translations;
+	// Lookup tables into the dictionaries in translations, used by translateSection()
+	struct TranslationIndex
+	{
+		QHash<QString/*english*/, qsizetype/*first entry with this text*/> byEnglish;
+		QHash<QString/*comment*/, std::vector<qsizetype>/*entries in ascending order*/> byComment;
+	};
+	QHash<QString/*locale*/, TranslationIndex> translationIndices;
 	QHash<QString/*locale*/, QString/*header*/> poHeaders;
-	std::set<DictEntry> allMarkdownSections;
-	bool dumpMarkdown(const QString& outDir) const;
-	void locateAndRelocateAllInlineImages(QString& html, bool saveToRefs);
+	// Untranslated sections in order of first appearance, sorted only when dumping
+	std::vector<DictEntry> allMarkdownSections;
+	QSet<EntryFingerprint> allMarkdownSectionFingerprints;
+	bool nativePoWriter = false;
+	const FileSystem* fileSystem = &FileSystem::disk();
+	const Progress* progress = &Progress::none();
+	ConverterContext* context = nullptr;
+	QString markdownCacheDir;
+	bool dumpMarkdown(OutputDir& outDir) const;
+	void locateAndRelocateAllInlineImages(QByteArray& htmlUtf8, bool saveToRefs);
 	void addUntranslatedNames(const QString scName, const ConstellationOldLoader& consLoader, const AsterismOldLoader& astLoader, const NamesOldLoader& namesLoader);
 	void loadTranslationsOfNames(const QString& poBaseDir, const QString& cultureId, const QString& englishName,
 	                             const ConstellationOldLoader& consLoader, const AsterismOldLoader& astLoader, const NamesOldLoader& namesLoader);
+	void indexTranslations();
 	QString translateSection(const QString& markdown, const qsizetype bodyStartPos, const qsizetype bodyEndPos, const QString& locale, const QString& sectionName);
 	QString translateDescription(const QString& markdown, const QString& locale);
+	QString convertHTMLToMarkdownCached(QByteArray html, bool footnotesToRefs) const;
 public:
 	void load(const QString& inDir, const QString& poBaseDir, const QString& cultureId, const QString& englishName,
 	          const QString& author, const QString& credit, const QString& license,
 	          const ConstellationOldLoader& consLoader, const AsterismOldLoader& astLoader, const NamesOldLoader& namesLoader,
 	          bool footnotesToRefs, bool genTranslatedMD);
-	bool dump(const QString& outDir) const;
+	bool dump(OutputDir& outDir) const;
+	//! Makes dump() serialize the .po files by itself instead of via libgettextpo
+	void setNativePoWriter(const bool enable) { nativePoWriter = enable; }
+	//! Makes load() keep the Markdown converted from each description in dir, keyed by the hash of the HTML
+	void setMarkdownCache(const QString& dir) { markdownCacheDir = dir; }
+	//! Makes the loader read the sky culture through fs instead of from the disk. Translations
+	//! are still read from the disk.
+	void setFileSystem(const FileSystem& fs) { fileSystem = &fs; }
+	//! Makes the loader report its progress to p and stop early when it's cancelled. A cancelled dump() fails.
+	void setProgress(const Progress& p) { progress = &p; }
+	//! Makes load() take the parsed catalogs of stellarium-skycultures from the cache of ctx
+	void setContext(ConverterContext& ctx) { context = &ctx; }
 };
+
+//! Appends a subsection with a heading of the given level to the Markdown of a section, as
+//! the .po entry of the section holds them. Any trailing whitespace is stripped, including
+//! U+00A0, U+3000 etc. that the bodies of the sections keep.
+void appendSubsection(QString& markdown, int level, const QString& title, QStringView body);
+//! Tidies the UTF-8 HTML of a description up into XHTML. Returns an empty array on failure.
+QByteArray tidyDescriptionHTML(const QByteArray& html);
+//! Converts tidied XHTML to Markdown through a DOM tree. convertXHTMLToMarkdown() of
+//! XHTMLStreamConverter.hpp gives the same result faster for most descriptions, and the
+//! descriptions it can't convert are passed to this one.
+QString convertXHTMLToMarkdownWithDOM(const QByteArray& xhtml, bool footnotesToRefs);
@@ -0,0 +1,281 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "Diagnostics.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <QDebug>
+#include <QtGlobal>
+#include "Utils.hpp"
+
+namespace Diagnostics
+{
+
+namespace
+{
+
+constexpr std::size_t consoleBufferLimit = 1 << 14;
+constexpr auto consoleFlushInterval = std::chrono::milliseconds(200);
+
+thread_local Scope* currentScope = nullptr;
+
+std::mutex handlerMutex; // guards the installation of the message handler
+int activeScopes = 0;
+std::atomic<QtMessageHandler> previousMessageHandler{nullptr};
+
+QString location(const QString& file, const int line)
+{
+	if(file.isEmpty()) return {};
+	return line > 0 ? QString("%1:%2: ").arg(file).arg(line) : file + ": ";
+}
+
+// Formats the record like compilers do, prefixed with its tags,
+// e.g. "[western/names] star_names.fab:12: warning: empty name field [parse-error]"
+QString format(const Record& record)
+{
+	QString text;
+	if(!record.culture.isEmpty() || !record.stage.isEmpty())
+	{
+		const auto separator = record.culture.isEmpty() || record.stage.isEmpty() ? "" : "/";
+		text = "[" + record.culture + separator + record.stage + "] ";
+	}
+	text += location(record.file, record.line);
+	if(record.severity == Severity::Warning || record.severity == Severity::Error)
+		text += QString(severityName(record.severity)) + ": ";
+	text += record.message;
+	if(!record.code.isEmpty() && record.code != "log")
+		text += " [" + record.code + "]";
+	return text;
+}
+
+void deliver(Scope& scope, const Context& context, Record record)
+{
+	record.culture = context.culture;
+	record.stage = context.stage;
+	switch(context.collector->report(record))
+	{
+	case Collector::ConsoleAction::None:
+		break;
+	case Collector::ConsoleAction::Print:
+		scope.print(format(record));
+		break;
+	case Collector::ConsoleAction::NoteSuppression:
+		scope.print("Further messages are suppressed");
+		break;
+	}
+	if(record.severity == Severity::Error)
+		scope.flush();
+}
+
+Severity severityOf(const QtMsgType type)
+{
+	switch(type)
+	{
+	case QtDebugMsg:    return Severity::Debug;
+	case QtInfoMsg:     return Severity::Info;
+	case QtWarningMsg:  return Severity::Warning;
+	case QtCriticalMsg:
+	case QtFatalMsg:    break;
+	}
+	return Severity::Error;
+}
+
+void messageHandler(const QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+	if(const auto scope = currentScope)
+	{
+		const auto scopeContext = Context::current();
+		if(scopeContext.collector)
+		{
+			deliver(*scope, scopeContext, {severityOf(type), {}, 0, "log", message});
+			if(type != QtFatalMsg) return;
+		}
+	}
+	if(const auto handler = previousMessageHandler.load())
+		handler(type, context, message);
+}
+
+}
+
+const char* severityName(const Severity severity)
+{
+	switch(severity)
+	{
+	case Severity::Debug:   return "debug";
+	case Severity::Info:    return "info";
+	case Severity::Warning: return "warning";
+	case Severity::Error:   return "error";
+	}
+	return "unknown";
+}
+
+auto Collector::report(const Record& record) -> ConsoleAction
+{
+	const QChar separator(0);
+	const auto key = QString::number(int(record.severity)) + separator + record.culture + separator + record.code +
+	                 separator + record.file + separator + QString::number(record.line) + separator + record.message;
+	std::lock_guard lock(mutex);
+	if(record.severity < minSeverity)
+		return ConsoleAction::None;
+	++severityCounts[int(record.severity)];
+	if(const auto it = recordIndices.constFind(key); it != recordIndices.cend())
+	{
+		++allRecords[it.value()].count;
+		return ConsoleAction::None;
+	}
+	recordIndices.insert(key, allRecords.size());
+	allRecords.push_back(record);
+
+	if(!consoleEnabled || record.severity < consoleMinSeverity)
+		return ConsoleAction::None;
+	if(consoleMaxMessages < 0 || consoleMessages < consoleMaxMessages)
+	{
+		++consoleMessages;
+		return ConsoleAction::Print;
+	}
+	// The note takes the place of the first message left out, so there's none when exactly maxMessages arrive
+	if(consoleMessages == consoleMaxMessages)
+	{
+		++consoleMessages;
+		return ConsoleAction::NoteSuppression;
+	}
+	return ConsoleAction::None;
+}
+
+std::vector<Record> Collector::records() const
+{
+	std::lock_guard lock(mutex);
+	return allRecords;
+}
+
+int Collector::count(const Severity severity) const
+{
+	std::lock_guard lock(mutex);
+	return severityCounts[int(severity)];
+}
+
+QByteArray Collector::toJSON() const
+{
+	std::lock_guard lock(mutex);
+	QByteArray json = "[";
+	for(std::size_t n = 0; n < allRecords.size(); ++n)
+	{
+		const auto& r = allRecords[n];
+		json += n ? ",\n  " : "\n  ";
+		json += "{\"severity\": \"" + QByteArray(severityName(r.severity)) + "\", "
+		        "\"culture\": \"" + jsonEscape(r.culture).toUtf8() + "\", "
+		        "\"stage\": \"" + jsonEscape(r.stage).toUtf8() + "\", "
+		        "\"file\": \"" + jsonEscape(r.file).toUtf8() + "\", "
+		        "\"line\": " + QByteArray::number(r.line) + ", "
+		        "\"code\": \"" + jsonEscape(r.code).toUtf8() + "\", "
+		        "\"message\": \"" + jsonEscape(r.message).toUtf8() + "\", "
+		        "\"count\": " + QByteArray::number(r.count) + "}";
+	}
+	json += allRecords.empty() ? "]\n" : "\n]\n";
+	return json;
+}
+
+void Collector::setMinSeverity(const Severity severity)
+{
+	std::lock_guard lock(mutex);
+	minSeverity = severity;
+}
+
+void Collector::setConsoleSink(const Severity minSeverity, const int maxMessages)
+{
+	std::lock_guard lock(mutex);
+	consoleEnabled = true;
+	consoleMinSeverity = minSeverity;
+	consoleMaxMessages = maxMessages;
+}
+
+Context Context::current()
+{
+	return currentScope ? currentScope->context : Context{};
+}
+
+Scope::Scope(Context context)
+	: context(std::move(context))
+	, outer(currentScope)
+	, lastFlush(std::chrono::steady_clock::now())
+{
+	currentScope = this;
+	std::lock_guard lock(handlerMutex);
+	if(activeScopes++ == 0)
+		previousMessageHandler = qInstallMessageHandler(messageHandler);
+}
+
+Scope::~Scope()
+{
+	flush();
+	currentScope = outer;
+	std::lock_guard lock(handlerMutex);
+	if(--activeScopes == 0)
+		qInstallMessageHandler(previousMessageHandler.exchange(nullptr));
+}
+
+void Scope::print(const QString& line)
+{
+	consoleBuffer += line.toStdString();
+	consoleBuffer += '\n';
+	if(consoleBuffer.size() >= consoleBufferLimit ||
+	   std::chrono::steady_clock::now() - lastFlush >= consoleFlushInterval)
+		flush();
+}
+
+void Scope::flush()
+{
+	lastFlush = std::chrono::steady_clock::now();
+	if(consoleBuffer.empty()) return;
+	// A single write per block keeps the lines of different threads from interleaving
+	std::fwrite(consoleBuffer.data(), 1, consoleBuffer.size(), stderr);
+	std::fflush(stderr);
+	consoleBuffer.clear();
+}
+
+void setStage(const QString& stage)
+{
+	if(currentScope)
+		currentScope->context.stage = stage;
+}
+
+void report(const Severity severity, const QString& code, const QString& message, const QString& file, const int line)
+{
+	if(const auto scope = currentScope)
+	{
+		const auto context = Context::current();
+		if(context.collector)
+		{
+			deliver(*scope, context, {severity, file, line, code, message});
+			return;
+		}
+	}
+
+	const auto text = location(file, line) + message;
+	switch(severity)
+	{
+	case Severity::Debug:   qDebug().noquote()    << text; break;
+	case Severity::Info:    qInfo().noquote()     << text; break;
+	case Severity::Warning: qWarning().noquote()  << text; break;
+	case Severity::Error:   qCritical().noquote() << text; break;
+	}
+}
+
+}
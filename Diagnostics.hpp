@@ -0,0 +1,152 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+//! Problems found while converting a sky culture, reported as structured records rather than
+//! printed immediately, so that they can be deduplicated, counted and processed by other programs.
+namespace Diagnostics
+{
+
+enum class Severity
+{
+	Debug,
+	Info,
+	Warning,
+	Error,
+};
+const char* severityName(Severity severity);
+
+struct Record
+{
+	Severity severity = Severity::Warning;
+	QString file;    //!< Input file the problem was found in, or empty if not applicable
+	int line = 0;    //!< 1-based line in the file, or 0 if not applicable
+	QString code;    //!< Stable identifier of the kind of problem, e.g. "parse-error"
+	QString message;
+	QString culture; //!< ID of the sky culture being converted
+	QString stage;   //!< Stage of the conversion, e.g. "names" or "description"
+	int count = 1;   //!< How many times this very record was reported
+};
+
+//! Collects the records reported while a Scope is active. Identical records are stored
+//! once with a repeat count. The methods may be called concurrently.
+class Collector
+{
+public:
+	enum class ConsoleAction
+	{
+		None,
+		Print,
+		NoteSuppression, //!< Don't print the record, the first one over the limit, but note that the rest won't be printed
+	};
+	//! Stores the record and tells what should be printed about it
+	ConsoleAction report(const Record& record);
+	//! Distinct records in the order of their first occurrence
+	std::vector<Record> records() const;
+	//! Number of reports of the given severity, repeats included
+	int count(Severity severity) const;
+	//! Records as a JSON array of objects with the fields of Record
+	QByteArray toJSON() const;
+
+	//! Makes the collector ignore the reports less severe than minSeverity
+	void setMinSeverity(Severity minSeverity);
+	//! Makes the collector print the distinct records of at least minSeverity to stderr as they
+	//! arrive. At most maxMessages are printed if it's nonnegative, and a note that the rest were
+	//! suppressed replaces the first one over the limit. The output is buffered per thread, see Scope.
+	void setConsoleSink(Severity minSeverity, int maxMessages = -1);
+
+private:
+	mutable std::mutex mutex;
+	std::vector<Record> allRecords;
+	QHash<QString/*key*/, std::size_t/*index in allRecords*/> recordIndices;
+	int severityCounts[4] = {};
+
+	Severity minSeverity = Severity::Debug;
+	bool consoleEnabled = false;
+	Severity consoleMinSeverity = Severity::Debug;
+	int consoleMaxMessages = -1;
+	int consoleMessages = 0;
+};
+
+//! Where the reports of a thread go and how they are tagged
+struct Context
+{
+	Collector* collector = nullptr;
+	QString culture;
+	QString stage;
+
+	//! Context of the innermost Scope of the calling thread. Work handed over to other threads
+	//! should capture it and open a Scope with it there, so that its reports are tagged alike.
+	static Context current();
+};
+
+//! Makes the context current in the calling thread while the scope lives. The messages of
+//! qDebug(), qWarning() etc. from the thread are reported too, with the code "log".
+//! Console output of the scope is accumulated in a buffer owned by the thread, and
+//! written out in blocks, so that threads neither contend for stderr on every line nor
+//! interleave their lines. Scopes may be nested, the innermost one gets the reports.
+class Scope
+{
+public:
+	explicit Scope(Context context);
+	~Scope();
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+	void print(const QString& line);
+	void flush();
+
+private:
+	friend void setStage(const QString& stage);
+	friend Context Context::current();
+
+	Context context;
+	Scope* outer;
+	std::string consoleBuffer;
+	std::chrono::steady_clock::time_point lastFlush;
+};
+
+//! Sets the stage that the reports of the innermost Scope of the calling thread are tagged with
+void setStage(const QString& stage);
+
+//! Reports to the collector of the innermost Scope of the calling thread. Without one, prints the message through Qt logging.
+void report(Severity severity, const QString& code, const QString& message, const QString& file = {}, int line = 0);
+inline void info(const QString& code, const QString& message, const QString& file = {}, int line = 0)
+{
+	report(Severity::Info, code, message, file, line);
+}
+inline void warning(const QString& code, const QString& message, const QString& file = {}, int line = 0)
+{
+	report(Severity::Warning, code, message, file, line);
+}
+inline void error(const QString& code, const QString& message, const QString& file = {}, int line = 0)
+{
+	report(Severity::Error, code, message, file, line);
+}
+
+}
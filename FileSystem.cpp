@@ -0,0 +1,158 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "FileSystem.hpp"
+
+#include <algorithm>
+#include <QDir>
+#include <QFile>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+namespace
+{
+
+class DiskFileSystem : public FileSystem
+{
+public:
+	std::unique_ptr<QIODevice> open(const QString& path, const QIODevice::OpenMode mode) const override
+	{
+		auto file = std::make_unique<QFile>(path);
+		if(!file->open(mode))
+			return nullptr;
+		return file;
+	}
+	bool exists(const QString& path) const override
+	{
+		return QFileInfo::exists(path);
+	}
+	qint64 size(const QString& path) const override
+	{
+		const QFileInfo info(path);
+		return info.isFile() ? info.size() : -1;
+	}
+	QStringList entryList(const QString& dirPath, const QStringList& nameFilters) const override
+	{
+		return QDir(dirPath).entryList(nameFilters);
+	}
+	QString localPath(const QString& path) const override
+	{
+		return path;
+	}
+};
+
+// QDir matches the name filters case-insensitively by default
+bool matchesAnyFilter(const QString& name, const QStringList& nameFilters)
+{
+	return std::any_of(nameFilters.begin(), nameFilters.end(), [&name](const QString& filter)
+	{
+		const QRegularExpression re(QRegularExpression::wildcardToRegularExpression(filter),
+		                            QRegularExpression::CaseInsensitiveOption);
+		return re.match(name).hasMatch();
+	});
+}
+
+}
+
+std::optional<QByteArray> FileSystem::readAll(const QString& path) const
+{
+	const auto device = open(path);
+	if(!device) return std::nullopt;
+	return device->readAll();
+}
+
+const FileSystem& FileSystem::disk()
+{
+	static const DiskFileSystem fs;
+	return fs;
+}
+
+MemoryFileSystem::MemoryFileSystem(const QString& rootDir, Files files)
+	: root(QDir::cleanPath(rootDir))
+	, files(std::move(files))
+{
+}
+
+std::optional<QString> MemoryFileSystem::relativePath(const QString& path) const
+{
+	const auto clean = QDir::cleanPath(path);
+	if(clean == root)
+		return QString();
+	if(!clean.startsWith(root) || clean.size() <= root.size() || clean[root.size()] != '/')
+		return std::nullopt;
+	return clean.mid(root.size() + 1);
+}
+
+const QByteArray* MemoryFileSystem::find(const QString& path) const
+{
+	const auto rel = relativePath(path);
+	if(!rel) return nullptr;
+	const auto it = files.find(*rel);
+	return it == files.end() ? nullptr : &it->second;
+}
+
+std::unique_ptr<QIODevice> MemoryFileSystem::open(const QString& path, const QIODevice::OpenMode mode) const
+{
+	const auto data = find(path);
+	if(!data || (mode & QIODevice::WriteOnly))
+		return nullptr;
+	// The buffer refers to the stored contents, which are never modified
+	auto buffer = std::make_unique<QBuffer>();
+	buffer->setData(*data);
+	if(!buffer->open(mode))
+		return nullptr;
+	return buffer;
+}
+
+bool MemoryFileSystem::exists(const QString& path) const
+{
+	const auto rel = relativePath(path);
+	if(!rel) return false;
+	if(rel->isEmpty() || files.count(*rel)) return true;
+	// A directory exists if there are files in it
+	const auto dirPrefix = *rel + '/';
+	const auto it = files.lower_bound(dirPrefix);
+	return it != files.end() && it->first.startsWith(dirPrefix);
+}
+
+qint64 MemoryFileSystem::size(const QString& path) const
+{
+	const auto data = find(path);
+	return data ? data->size() : -1;
+}
+
+QStringList MemoryFileSystem::entryList(const QString& dirPath, const QStringList& nameFilters) const
+{
+	const auto rel = relativePath(dirPath);
+	if(!rel) return {};
+	const auto dirPrefix = rel->isEmpty() ? QString() : *rel + '/';
+	QStringList names;
+	for(auto it = files.lower_bound(dirPrefix); it != files.end() && it->first.startsWith(dirPrefix); ++it)
+	{
+		const auto name = it->first.mid(dirPrefix.size());
+		if(name.contains('/')) continue; // in a subdirectory
+		if(nameFilters.isEmpty() || matchesAnyFilter(name, nameFilters))
+			names.push_back(name);
+	}
+	// QDir sorts by name case-insensitively by default
+	std::sort(names.begin(), names.end(), [](const QString& a, const QString& b)
+	          { return QString::compare(a, b, Qt::CaseInsensitive) < 0; });
+	return names;
+}
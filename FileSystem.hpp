@@ -0,0 +1,76 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <QString>
+#include <QIODevice>
+#include <QByteArray>
+#include <QStringList>
+
+//! Read-only access to the files of a legacy sky culture. The loaders read through this
+//! interface, so that a sky culture can be converted from memory as well as from disk.
+//! The methods may be called concurrently.
+class FileSystem
+{
+public:
+	virtual ~FileSystem() = default;
+
+	//! Opens the file in the given mode, which must be a read mode. Returns nullptr on failure.
+	virtual std::unique_ptr<QIODevice> open(const QString& path, QIODevice::OpenMode mode = QIODevice::ReadOnly) const = 0;
+	//! Whether a file or a directory exists at the path
+	virtual bool exists(const QString& path) const = 0;
+	//! Size of the file in bytes, or -1 if there's no such file
+	virtual qint64 size(const QString& path) const = 0;
+	//! Names of the files in the directory that match any of the wildcard filters, sorted like QDir::entryList() sorts them
+	virtual QStringList entryList(const QString& dirPath, const QStringList& nameFilters) const = 0;
+	//! Path at which the file can be opened by libraries that only accept file names, or an empty string if there's none
+	virtual QString localPath(const QString& path) const = 0;
+
+	//! Reads the whole file, returning std::nullopt if it can't be opened
+	std::optional<QByteArray> readAll(const QString& path) const;
+
+	//! The file system of the host
+	static const FileSystem& disk();
+};
+
+//! Files held in memory, keyed by paths relative to a root directory. Paths given to the
+//! methods are resolved against the root, e.g. "root/info.ini" refers to the "info.ini" entry.
+class MemoryFileSystem : public FileSystem
+{
+public:
+	using Files = std::map<QString/*relative path*/, QByteArray/*contents*/>;
+	MemoryFileSystem(const QString& rootDir, Files files);
+
+	std::unique_ptr<QIODevice> open(const QString& path, QIODevice::OpenMode mode = QIODevice::ReadOnly) const override;
+	bool exists(const QString& path) const override;
+	qint64 size(const QString& path) const override;
+	QStringList entryList(const QString& dirPath, const QStringList& nameFilters) const override;
+	QString localPath(const QString&) const override { return {}; }
+
+private:
+	std::optional<QString> relativePath(const QString& path) const;
+	const QByteArray* find(const QString& path) const;
+
+	QString root;
+	Files files;
+};
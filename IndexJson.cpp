@@ -0,0 +1,37 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "IndexJson.hpp"
+
+std::string joinSections(std::vector<std::string>& sections)
+{
+	std::string out;
+	for(auto& section : sections)
+	{
+		if(section.empty())
+			continue;
+		if(section.ends_with(",\n"))
+			section.resize(section.size() - 2);
+		if(!out.empty())
+			out += ",\n";
+		out += section;
+	}
+	out += "\n}\n";
+	return out;
+}
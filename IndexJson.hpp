@@ -0,0 +1,46 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <future>
+#include <string>
+#include <vector>
+#include <sstream>
+#include "Diagnostics.hpp"
+
+//! Serializes the section of index.json held by the loader in another thread. The loader
+//! must outlive the returned future, and its diagnostics go to the caller's collector.
+template<typename Loader>
+std::future<std::string> dumpSectionAsync(const Loader& loader)
+{
+	return std::async(std::launch::async, [&loader, context = Diagnostics::Context::current()]
+	{
+		Diagnostics::Scope diagnosticsScope(context);
+		std::stringstream s;
+		loader.dumpJSON(s);
+		return std::move(s).str();
+	});
+}
+
+//! Joins the sections of index.json in the given order and closes the top-level object. Each
+//! section is written by its loader as if it were followed by another one, i.e. it ends with
+//! ",\n". Here this separator is dropped and inserted only between non-empty sections, so the
+//! result is the same as if all the sections had been written serially into one stream.
+std::string joinSections(std::vector<std::string>& sections);
@@ -20,12 +20,15 @@
 #include "NamesOldLoader.hpp"
 
 #include <string>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <QDir>
-#include <QFile>
 #include <QDebug>
-#include <QFileInfo>
-#include <QRegularExpression>
 #include "Utils.hpp"
+#include "Regex.hpp"
+#include "Diagnostics.hpp"
 
 template<typename Map>
 void coalesceEnglishAndNativeNamesIntoSingleEntries(Map& data)
@@ -53,21 +56,22 @@ void NamesOldLoader::loadStarNames(const QString& skyCultureDir, const QString&
                                    const bool convertUntranslatableNamesToNative)
 {
 	const auto nameFile = skyCultureDir + "/star_names.fab";
-	if(!QFileInfo(nameFile).exists())
+	if(!fileSystem->exists(nameFile))
 	{
 		qWarning() << "No star names found";
 		return;
 	}
-	QFile cnFile(nameFile);
-	if (!cnFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto cnFileDevice = fileSystem->open(nameFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!cnFileDevice)
 	{
 		qWarning().noquote() << "WARNING - could not open" << QDir::toNativeSeparators(nameFile);
 		return;
 	}
+	auto& cnFile = *cnFileDevice;
 	const auto nativeNameFile = skyCultureDir + "/star_names." + nativeLocale + ".fab";
-	QFile nativeFile(nativeNameFile);
+	std::unique_ptr<QIODevice> nativeFile;
 	bool useNative = !nativeLocale.isEmpty();
-	if (useNative && !nativeFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	if (useNative && !(nativeFile = fileSystem->open(nativeNameFile, QIODevice::ReadOnly | QIODevice::Text)))
 	{
 		qWarning().noquote() << "WARNING - could not open" << QDir::toNativeSeparators(nativeNameFile);
                 useNative = false;
@@ -79,24 +83,25 @@ void NamesOldLoader::loadStarNames(const QString& skyCultureDir, const QString&
 	int lineNumberInNative=0;
 	QString record, nativeRecord;
 	// Allow empty and comment lines where first char (after optional blanks) is #
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 	// record structure is delimited with a | character.  We will
 	// use a QRegularExpression to extract the fields. with white-space padding permitted
 	// (i.e. it will be stripped automatically) Example record strings:
 	// "   677|_("Alpheratz")"
 	// "113368|_("Fomalhaut")"
 	// Note: Stellarium doesn't support sky cultures made prior to version 0.10.6 now!
-	static const QRegularExpression recordRx("^\\s*(\\d+)\\s*\\|(_*)[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)");
+	const auto& recordRx = Regex::get(Regex::StarNameRecord);
 
 	QString translatorsComments;
 	while(!cnFile.atEnd())
 	{
+		if (progress->cancelled()) return;
 		record = QString::fromUtf8(cnFile.readLine()).trimmed();
 		lineNumber++;
 		const auto commentMatch = commentRx.match(record);
 		if (commentMatch.hasMatch())
 		{
-			const auto comment = commentMatch.captured(1).trimmed().replace(QRegularExpression("^#\\s*"), "");
+			const auto comment = Regex::get(Regex::CommentHashPrefix).replaced(commentMatch.captured(1).trimmed(), "");
 			if(comment.startsWith(translatorsCommentPrefix))
 				translatorsComments += comment.mid(translatorsCommentPrefix.size()).trimmed() + "\n";
 			else if(!comment.isEmpty())
@@ -106,11 +111,11 @@ void NamesOldLoader::loadStarNames(const QString& skyCultureDir, const QString&
 
 		if (useNative)
 		{
-			while (!nativeFile.atEnd() && nativeRecord.isEmpty())
+			while (!nativeFile->atEnd() && nativeRecord.isEmpty())
 			{
-				nativeRecord = QString::fromUtf8(nativeFile.readLine()).trimmed();
+				nativeRecord = QString::fromUtf8(nativeFile->readLine()).trimmed();
 				++lineNumberInNative;
-				if (nativeRecord.contains(commentRx))
+				if (commentRx.matches(nativeRecord))
 					nativeRecord.clear();
 			}
 		}
@@ -119,9 +124,8 @@ void NamesOldLoader::loadStarNames(const QString& skyCultureDir, const QString&
 		QRegularExpressionMatch recMatch=recordRx.match(record);
 		if (!recMatch.hasMatch())
 		{
-			qWarning().noquote() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(nameFile)
-				   << " - record does not match record pattern";
-			qWarning().noquote() << "Problematic record:" << record;
+			Diagnostics::warning("parse-error", "record does not match record pattern: " + record,
+			                     QDir::toNativeSeparators(nameFile), lineNumber);
 			translatorsComments = "";
 			continue;
 		}
@@ -132,16 +136,15 @@ void NamesOldLoader::loadStarNames(const QString& skyCultureDir, const QString&
 			const int hip = recMatch.captured(1).toInt(&ok);
 			if (!ok)
 			{
-				qWarning().noquote() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(nameFile)
-					   << " - failed to convert " << recMatch.captured(1) << "to a number";
+				Diagnostics::warning("parse-error", "failed to convert " + recMatch.captured(1) + " to a number",
+				                     QDir::toNativeSeparators(nameFile), lineNumber);
 				translatorsComments = "";
 				continue;
 			}
 			const QString name = recMatch.captured(3).trimmed();
 			if (name.isEmpty())
 			{
-				qWarning().noquote() << "WARNING - parse error at line" << lineNumber << "in" << QDir::toNativeSeparators(nameFile)
-					   << " - empty name field";
+				Diagnostics::warning("parse-error", "empty name field", QDir::toNativeSeparators(nameFile), lineNumber);
 				translatorsComments = "";
 				continue;
 			}
@@ -160,15 +163,15 @@ void NamesOldLoader::loadStarNames(const QString& skyCultureDir, const QString&
 				{
 					if (nativeRecord.isEmpty())
 					{
-						qWarning() << "Premature end of file at line" << lineNumberInNative << "in" << QDir::toNativeSeparators(nativeNameFile)
-						           << "while parsing line" << lineNumber << "in" << QDir::toNativeSeparators(nameFile);
+						Diagnostics::warning("premature-end", QString("premature end of file while parsing line %1 in %2")
+						                         .arg(lineNumber).arg(QDir::toNativeSeparators(nameFile)),
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 						useNative = false;
 					}
 					else
 					{
-						qWarning().noquote() << "WARNING - parse error at line" << lineNumberInNative << "in" << QDir::toNativeSeparators(nativeNameFile)
-						                     << " - record does not match record pattern";
-						qWarning().noquote() << "Problematic record:" << nativeRecord;
+						Diagnostics::warning("parse-error", "record does not match record pattern: " + nativeRecord,
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 					}
 				}
 				else
@@ -177,19 +180,21 @@ void NamesOldLoader::loadStarNames(const QString& skyCultureDir, const QString&
 					const int nativeHIP = nativeRecMatch.captured(1).toInt(&ok);
 					if (!ok)
 					{
-						qWarning().noquote() << "WARNING - parse error at line" << lineNumberInNative << "in" << QDir::toNativeSeparators(nativeNameFile)
-						                     << " - failed to convert " << nativeRecMatch.captured(1) << "to a number";
+						Diagnostics::warning("parse-error", "failed to convert " + nativeRecMatch.captured(1) + " to a number",
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 					}
 					else if(nativeHIP != hip)
 					{
-						qWarning().nospace() << "WARNING: star id in native names file at line " << lineNumberInNative
-						                     << " differs from that in English names file at line " << lineNumber
-						                     << ". Will ignore all native star names after this point";
+						Diagnostics::warning("native-names-mismatch",
+						                     QString("star id differs from that in English names file at line %1. "
+						                             "Will ignore all native star names after this point").arg(lineNumber),
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 						useNative = false;
 					}
 					else if (realNativeName.isEmpty())
 					{
-						qWarning() << "WARNING: no native name at line" << lineNumberInNative << "in" << QDir::toNativeSeparators(nativeNameFile);
+						Diagnostics::warning("missing-native-name", "no native name",
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 					}
 					else
 					{
@@ -228,22 +233,23 @@ void NamesOldLoader::loadDSONames(const QString& skyCultureDir, const QString& n
                                   const bool convertUntranslatableNamesToNative)
 {
 	const auto namesFile = skyCultureDir + "/dso_names.fab";
-	if(!QFileInfo(namesFile).exists())
+	if(!fileSystem->exists(namesFile))
 	{
 		qWarning() << "No DSO names found";
 		return;
 	}
-	QFile dsoNamesFile(namesFile);
-	if (!dsoNamesFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto dsoNamesFileDevice = fileSystem->open(namesFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!dsoNamesFileDevice)
 	{
 		qWarning() << "Failed to open file" << QDir::toNativeSeparators(namesFile);
 		return;
 	}
+	auto& dsoNamesFile = *dsoNamesFileDevice;
 
 	const auto nativeNameFile = skyCultureDir + "/dso_names." + nativeLocale + ".fab";
-	QFile nativeFile(nativeNameFile);
+	std::unique_ptr<QIODevice> nativeFile;
 	bool useNative = !nativeLocale.isEmpty();
-	if (useNative && !nativeFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	if (useNative && !(nativeFile = fileSystem->open(nativeNameFile, QIODevice::ReadOnly | QIODevice::Text)))
 	{
 		qWarning() << "Failed to open file" << QDir::toNativeSeparators(nativeNameFile);
                 useNative = false;
@@ -251,11 +257,11 @@ void NamesOldLoader::loadDSONames(const QString& skyCultureDir, const QString& n
 
 	// Now parse the file
 	// lines to ignore which start with a # or are empty
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 
 	// lines which look like records - we use the RE to extract the fields
 	// which will be available in recMatch.capturedTexts()
-	static const QRegularExpression recRx("^\\s*([\\w\\s\\-\\+\\.]+)\\s*\\|(_*)[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)");
+	const auto& recRx = Regex::get(Regex::DSONameRecord);
 
 	QString record, nativeRecord, dsoId;
 	int totalRecords=0;
@@ -265,13 +271,14 @@ void NamesOldLoader::loadDSONames(const QString& skyCultureDir, const QString& n
 	QString translatorsComments;
 	while (!dsoNamesFile.atEnd())
 	{
+		if (progress->cancelled()) return;
 		record = QString::fromUtf8(dsoNamesFile.readLine()).trimmed();
 		lineNumber++;
 
 		const auto commentMatch = commentRx.match(record);
 		if (commentMatch.hasMatch())
 		{
-			const auto comment = commentMatch.captured(1).trimmed().replace(QRegularExpression("^#\\s*"), "");
+			const auto comment = Regex::get(Regex::CommentHashPrefix).replaced(commentMatch.captured(1).trimmed(), "");
 			if(comment.startsWith(translatorsCommentPrefix))
 				translatorsComments += comment.mid(translatorsCommentPrefix.size()).trimmed() + "\n";
 			else if(!comment.isEmpty())
@@ -281,11 +288,11 @@ void NamesOldLoader::loadDSONames(const QString& skyCultureDir, const QString& n
 
 		if (useNative)
 		{
-			while (!nativeFile.atEnd() && nativeRecord.isEmpty())
+			while (!nativeFile->atEnd() && nativeRecord.isEmpty())
 			{
-				nativeRecord = QString::fromUtf8(nativeFile.readLine()).trimmed();
+				nativeRecord = QString::fromUtf8(nativeFile->readLine()).trimmed();
 				++lineNumberInNative;
-				if (nativeRecord.contains(commentRx))
+				if (commentRx.matches(nativeRecord))
 					nativeRecord.clear();
 			}
 		}
@@ -295,7 +302,8 @@ void NamesOldLoader::loadDSONames(const QString& skyCultureDir, const QString& n
 		QRegularExpressionMatch recMatch=recRx.match(record);
 		if (!recMatch.hasMatch())
 		{
-			qWarning().noquote() << "ERROR - cannot parse record at line" << lineNumber << "in native deep-sky object names file" << QDir::toNativeSeparators(namesFile);
+			Diagnostics::error("parse-error", "cannot parse record in deep-sky object names file",
+			                   QDir::toNativeSeparators(namesFile), lineNumber);
 		}
 		else
 		{
@@ -316,15 +324,15 @@ void NamesOldLoader::loadDSONames(const QString& skyCultureDir, const QString& n
 				{
 					if (nativeRecord.isEmpty())
 					{
-						qWarning() << "Premature end of file at line" << lineNumberInNative << "in" << QDir::toNativeSeparators(nativeNameFile)
-						           << "while parsing line" << lineNumber << "in" << QDir::toNativeSeparators(namesFile);
+						Diagnostics::warning("premature-end", QString("premature end of file while parsing line %1 in %2")
+						                         .arg(lineNumber).arg(QDir::toNativeSeparators(namesFile)),
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 						useNative = false;
 					}
 					else
 					{
-						qWarning().noquote() << "WARNING - parse error at line" << lineNumberInNative << "in" << QDir::toNativeSeparators(nativeNameFile)
-						                     << " - record does not match record pattern";
-						qWarning().noquote() << "Problematic record:" << nativeRecord;
+						Diagnostics::warning("parse-error", "record does not match record pattern: " + nativeRecord,
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 					}
 				}
 				else
@@ -333,9 +341,10 @@ void NamesOldLoader::loadDSONames(const QString& skyCultureDir, const QString& n
 					const auto realNativeName = nativeRecMatch.captured(3).trimmed(); // Use translatable text
 					if(nativeDSOId != dsoId)
 					{
-						qWarning().nospace() << "WARNING: DSO id in native names file at line " << lineNumberInNative
-						                     << " differs from that in English names file at line " << lineNumber
-						                     << ". Will ignore all native DSO names after this point";
+						Diagnostics::warning("native-names-mismatch",
+						                     QString("DSO id differs from that in English names file at line %1. "
+						                             "Will ignore all native DSO names after this point").arg(lineNumber),
+						                     QDir::toNativeSeparators(nativeNameFile), lineNumberInNative);
 						useNative = false;
 					}
 					else
@@ -374,26 +383,27 @@ auto NamesOldLoader::findDSO(QString const& englishName) const -> DSOName const*
 void NamesOldLoader::loadPlanetNames(const QString& skyCultureDir)
 {
 	const auto namesFile = skyCultureDir + "/planet_names.fab";
-	if(!QFileInfo(namesFile).exists())
+	if(!fileSystem->exists(namesFile))
 	{
 		qWarning() << "No planet names found";
 		return;
 	}
 	// Open file
-	QFile planetNamesFile(namesFile);
-	if (!planetNamesFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	const auto planetNamesFileDevice = fileSystem->open(namesFile, QIODevice::ReadOnly | QIODevice::Text);
+	if (!planetNamesFileDevice)
 	{
 		qWarning() << "Failed to open file" << QDir::toNativeSeparators(namesFile);
 		return;
 	}
+	auto& planetNamesFile = *planetNamesFileDevice;
 
 	// Now parse the file
 	// lines to ignore which start with a # or are empty
-	static const QRegularExpression commentRx("^(\\s*#.*|\\s*)$");
+	const auto& commentRx = Regex::get(Regex::FabCommentLine);
 
 	// lines which look like records - we use the RE to extract the fields
 	// which will be available in recRx.capturedTexts()
-	static const QRegularExpression recRx("^\\s*(\\w+)\\s+\"(.+)\"\\s+_[(]\"(.+)\"[)](?:\\n|$)");
+	const auto& recRx = Regex::get(Regex::PlanetNameRecord);
 
 	// keep track of how many records we processed.
 	int totalRecords=0;
@@ -402,13 +412,14 @@ void NamesOldLoader::loadPlanetNames(const QString& skyCultureDir)
 	QString translatorsComments;
 	while (!planetNamesFile.atEnd())
 	{
+		if (progress->cancelled()) return;
 		const auto record = QString::fromUtf8(planetNamesFile.readLine());
 		lineNumber++;
 
 		const auto commentMatch = commentRx.match(record);
 		if (commentMatch.hasMatch())
 		{
-			const auto comment = commentMatch.captured(1).trimmed().replace(QRegularExpression("^#\\s*"), "");
+			const auto comment = Regex::get(Regex::CommentHashPrefix).replaced(commentMatch.captured(1).trimmed(), "");
 			if(comment.startsWith(translatorsCommentPrefix))
 				translatorsComments += comment.mid(translatorsCommentPrefix.size()).trimmed() + "\n";
 			else if(!comment.isEmpty())
@@ -422,7 +433,8 @@ void NamesOldLoader::loadPlanetNames(const QString& skyCultureDir)
 		QRegularExpressionMatch match=recRx.match(record);
 		if (!match.hasMatch())
 		{
-			qWarning() << "ERROR - cannot parse record at line" << lineNumber << "in planet names file" << QDir::toNativeSeparators(namesFile);
+			Diagnostics::error("parse-error", "cannot parse record in planet names file",
+			                   QDir::toNativeSeparators(namesFile), lineNumber);
 		}
 		else
 		{
@@ -448,92 +460,127 @@ auto NamesOldLoader::findPlanet(QString const& englishName) const -> PlanetName
 void NamesOldLoader::load(const QString& skyCultureDir, const QString& nativeLocale,
                           const bool convertUntranslatableNamesToNative)
 {
+	progress->report("names", "star_names.fab", 0, 3);
 	loadStarNames(skyCultureDir, nativeLocale, convertUntranslatableNamesToNative);
+	if(progress->cancelled()) return;
+	progress->report("names", "dso_names.fab", 1, 3);
 	loadDSONames(skyCultureDir, nativeLocale, convertUntranslatableNamesToNative);
+	if(progress->cancelled()) return;
+	progress->report("names", "planet_names.fab", 2, 3);
 	loadPlanetNames(skyCultureDir);
 }
 
+namespace
+{
+
+void writeIndent(std::ostream& s, std::size_t width)
+{
+	for(; width; --width) s.put(' ');
+}
+
+void writeTranslatorsComments(std::ostream& s, const QString& comments)
+{
+	if(comments.isEmpty()) return;
+	s << ", \"translators_comments\": \"";
+	writeJSONEscaped(s, QStringView(comments).trimmed());
+	s << '"';
+}
+
+// Common for StarName and DSOName
+template<typename Name>
+void writeNameEntry(std::ostream& s, const Name& name)
+{
+	if(name.englishName.isEmpty())
+	{
+		s << "{\"native\": \"";
+		writeJSONEscaped(s, name.nativeName, true);
+	}
+	else if(name.nativeName.isEmpty())
+	{
+		s << "{\"english\": \"";
+		writeJSONEscaped(s, name.englishName, true);
+	}
+	else
+	{
+		s << "{\"english\": \"";
+		writeJSONEscaped(s, name.englishName, true);
+		s << "\", \"native\": \"";
+		writeJSONEscaped(s, name.nativeName, true);
+	}
+	s << '"';
+	if(!name.references.empty())
+	{
+		s << ", \"references\": [";
+		writeReferences(s, name.references);
+		s << ']';
+	}
+	writeTranslatorsComments(s, name.translatorsComments);
+	s << '}';
+}
+
+template<typename Values>
+void writeNameList(std::ostream& s, const std::size_t prefixSize, const Values& values)
+{
+	for(unsigned v = 0; v < values.size(); ++v)
+	{
+		if(v > 0) writeIndent(s, prefixSize);
+		writeNameEntry(s, values[v]);
+		if(v+1 != values.size()) s << ",\n";
+	}
+}
+
+}
+
 bool NamesOldLoader::dumpJSON(std::ostream& s) const
 {
 	if (starNames.isEmpty() && dsoNames.isEmpty() && planetNames.isEmpty())
 		return false;
 	s << "  \"common_names\": {\n";
-	const auto starKeys = starNames.keys();
-	for(int k = 0; k < starKeys.size(); ++k)
+	for(auto it = starNames.cbegin(); it != starNames.cend(); ++it)
 	{
-		const auto& key = starKeys[k];
-		const auto prefix = "    \"HIP " + std::to_string(key) + "\": [";
-		s << prefix;
-		const auto& values = starNames[key];
-		for(unsigned v = 0; v < values.size(); ++v)
-		{
-			if(v > 0) s << std::string(prefix.size(), ' ');
-			const auto refs = values[v].references.empty() ? "" :
-				", \"references\": [" + formatReferences(values[v].references) + "]";
-			auto xcomments = values[v].translatorsComments;
-			if(!xcomments.isEmpty())
-				xcomments = ", \"translators_comments\": \"" + jsonEscape(xcomments.trimmed()) + "\"";
-			if(values[v].englishName.isEmpty())
-				s << ("{\"native\": \"" + jsonEscapeAndWarn(values[v].nativeName) + '"' + refs + xcomments + "}").toStdString();
-			else if(values[v].nativeName.isEmpty())
-				s << ("{\"english\": \"" + jsonEscapeAndWarn(values[v].englishName) + '"' + refs + xcomments + "}").toStdString();
-			else
-				s << ("{\"english\": \"" + jsonEscapeAndWarn(values[v].englishName) + "\", \"native\": \"" + jsonEscapeAndWarn(values[v].nativeName) +'"' + refs + xcomments + "}").toStdString();
-			if(v+1 != values.size()) s << ",\n";
-		}
-		if(k+1 != starKeys.size() || !dsoNames.isEmpty() || !planetNames.isEmpty())
+		char prefix[32] = "    \"HIP ";
+		const auto keyEnd = std::to_chars(prefix + 9, prefix + sizeof prefix - 4, it.key()).ptr;
+		std::memcpy(keyEnd, "\": [", 4);
+		const std::size_t prefixSize = keyEnd + 4 - prefix;
+		s.write(prefix, prefixSize);
+		writeNameList(s, prefixSize, it.value());
+		if(std::next(it) != starNames.cend() || !dsoNames.isEmpty() || !planetNames.isEmpty())
 			s << "],\n";
 		else
 			s << "]\n";
 	}
 
-	const auto dsoKeys = dsoNames.keys();
-	for(int k = 0; k < dsoKeys.size(); ++k)
+	for(auto it = dsoNames.cbegin(); it != dsoNames.cend(); ++it)
 	{
-		const auto& key = dsoKeys[k];
-		const auto prefix = ("    \"" + key + "\": [").toStdString();
-		s << prefix;
-		const auto& values = dsoNames[key];
-		for(unsigned v = 0; v < values.size(); ++v)
-		{
-			if(v > 0) s << std::string(prefix.size(), ' ');
-			const auto refs = values[v].references.empty() ? "" :
-				", \"references\": [" + formatReferences(values[v].references) + "]";
-			auto xcomments = values[v].translatorsComments;
-			if(!xcomments.isEmpty())
-				xcomments = ", \"translators_comments\": \"" + jsonEscape(xcomments.trimmed()) + "\"";
-			if(values[v].englishName.isEmpty())
-				s << ("{\"native\": \"" + jsonEscapeAndWarn(values[v].nativeName) + '"' + refs + xcomments + "}").toStdString();
-			else if(values[v].nativeName.isEmpty())
-				s << ("{\"english\": \"" + jsonEscapeAndWarn(values[v].englishName) + '"' + refs + xcomments + "}").toStdString();
-			else
-				s << ("{\"english\": \"" + jsonEscapeAndWarn(values[v].englishName) + "\", \"native\": \"" + jsonEscapeAndWarn(values[v].nativeName) +'"' + refs + xcomments + "}").toStdString();
-			if(v+1 != values.size()) s << ",\n";
-		}
-		if(k+1 != dsoKeys.size() || !planetNames.isEmpty())
+		s << "    \"";
+		writeUtf8(s, it.key());
+		s << "\": [";
+		writeNameList(s, 5 + utf8Length(it.key()) + 4, it.value());
+		if(std::next(it) != dsoNames.cend() || !planetNames.isEmpty())
 			s << "],\n";
 		else
 			s << "]\n";
 	}
 
-	const auto planetKeys = planetNames.keys();
-	for(int k = 0; k < planetKeys.size(); ++k)
+	for(auto it = planetNames.cbegin(); it != planetNames.cend(); ++it)
 	{
-		const auto& key = planetKeys[k];
-		const auto prefix = ("    \"NAME " + key + "\": [").toStdString();
-		s << prefix;
-		const auto& values = planetNames[key];
+		s << "    \"NAME ";
+		writeUtf8(s, it.key());
+		s << "\": [";
+		const auto& values = it.value();
 		for(unsigned v = 0; v < values.size(); ++v)
 		{
-			if(v > 0) s << std::string(prefix.size(), ' ');
-			auto xcomments = values[v].translatorsComments;
-			if(!xcomments.isEmpty())
-				xcomments = ", \"translators_comments\": \"" + jsonEscape(xcomments.trimmed()) + "\"";
-			s << ("{\"english\": \"" + jsonEscapeAndWarn(values[v].english) +
-			   "\", \"native\": \"" + jsonEscapeAndWarn(values[v].native) + "\"" + xcomments + "}").toStdString();
+			if(v > 0) writeIndent(s, 10 + utf8Length(it.key()) + 4);
+			s << "{\"english\": \"";
+			writeJSONEscaped(s, values[v].english, true);
+			s << "\", \"native\": \"";
+			writeJSONEscaped(s, values[v].native, true);
+			s << '"';
+			writeTranslatorsComments(s, values[v].translatorsComments);
+			s << '}';
 			if(v+1 != values.size()) s << ", ";
 		}
-		if(k+1 != planetKeys.size())
+		if(std::next(it) != planetNames.cend())
 			s << "],\n";
 		else
 			s << "]\n";
@@ -23,6 +23,8 @@
 #include <iostream>
 #include <QMap>
 #include <QString>
+#include "FileSystem.hpp"
+#include "Progress.hpp"
 
 class NamesOldLoader
 {
@@ -53,6 +55,10 @@ public:
 		QString translatorsComments;
 	};
 	void load(const QString& skyCultureDir, const QString& nativeLocale, bool convertUntranslatableNamesToNative);
+	//! Makes the loader read the files through fs instead of from the disk
+	void setFileSystem(const FileSystem& fs) { fileSystem = &fs; }
+	//! Makes the loader report its progress to p and stop early when it's cancelled
+	void setProgress(const Progress& p) { progress = &p; }
 	const StarName* findStar(QString const& englishName) const;
 	const DSOName* findDSO(QString const& englishName) const;
 	const PlanetName* findPlanet(QString const& englishName) const;
@@ -71,4 +77,6 @@ private:
 	QMap<int/*HIP*/, std::vector<StarName>> starNames;
 	QMap<QString/*dsoId*/,std::vector<DSOName>> dsoNames;
 	QMap<QString/*planetId*/,std::vector<PlanetName>> planetNames;
+	const FileSystem* fileSystem = &FileSystem::disk();
+	const Progress* progress = &Progress::none();
 };
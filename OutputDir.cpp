@@ -0,0 +1,555 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "OutputDir.hpp"
+
+#include <atomic>
+#include <thread>
+#include <iterator>
+#include <algorithm>
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include "Utils.hpp"
+#include "Diagnostics.hpp"
+
+#ifdef Q_OS_UNIX
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/stat.h>
+#endif
+#ifdef Q_OS_LINUX
+# include <sys/ioctl.h>
+# include <linux/fs.h>
+#endif
+
+namespace
+{
+constexpr auto hashAlgorithm = QCryptographicHash::Blake2b_256;
+constexpr qint64 copyChunkSize = 1 << 16;
+// Copying is I/O-bound, so a few threads are enough to keep the disk busy
+const unsigned publishThreadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+constexpr std::size_t publishQueueCapacity = 64;
+// Bump this when the way images are scaled or encoded changes, to invalidate the image cache
+constexpr int imageEncoderVersion = 1;
+constexpr int jpegQuality = 90;
+
+#ifdef Q_OS_UNIX
+// Clones the file by a reflink if the filesystem supports it, otherwise lets the kernel copy the data
+bool cloneOrKernelCopy(const QString& from, const QString& to)
+{
+	const int in = ::open(QFile::encodeName(from).constData(), O_RDONLY | O_CLOEXEC);
+	if(in < 0) return false;
+	const int out = ::open(QFile::encodeName(to).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if(out < 0)
+	{
+		::close(in);
+		return false;
+	}
+
+	bool ok = false;
+# ifdef Q_OS_LINUX
+	ok = ::ioctl(out, FICLONE, in) == 0;
+	if(!ok)
+	{
+		struct stat st;
+		if(::fstat(in, &st) == 0)
+		{
+			off_t remaining = st.st_size;
+			while(remaining > 0)
+			{
+				const auto copied = ::copy_file_range(in, nullptr, out, nullptr, remaining, 0);
+				if(copied <= 0) break;
+				remaining -= copied;
+			}
+			ok = remaining == 0;
+		}
+	}
+# endif
+	::close(in);
+	if(::close(out) != 0) ok = false;
+	if(!ok) ::unlink(QFile::encodeName(to).constData());
+	return ok;
+}
+#endif
+
+// Makes the file at "to" have the contents of the blob at "from" in the cheapest way available
+bool linkOrCopy(const QString& from, const QString& to)
+{
+#ifdef Q_OS_UNIX
+	if(::link(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0)
+		return true;
+	if(cloneOrKernelCopy(from, to))
+		return true;
+#endif
+	return QFile::copy(from, to);
+}
+
+QByteArray hashFile(const FileSystem& fs, const QString& path)
+{
+	const auto file = fs.open(path);
+	if(!file)
+	{
+		qCritical().noquote() << "Failed to open file" << path;
+		return {};
+	}
+	QCryptographicHash hash(hashAlgorithm);
+	if(!hash.addData(file.get()))
+	{
+		qCritical().noquote() << "Failed to read" << path << ":" << file->errorString();
+		return {};
+	}
+	return hash.result();
+}
+}
+
+OutputDir::OutputDir(const QString& path)
+	: rootPath(path)
+	, publishQueue(publishThreadCount, publishQueueCapacity)
+{
+}
+
+OutputDir::OutputDir(InMemory)
+	: inMemory(true)
+	, publishQueue(publishThreadCount, publishQueueCapacity)
+{
+}
+
+OutputDir::~OutputDir()
+{
+	publishQueue.wait();
+}
+
+std::map<QString, QByteArray> OutputDir::takeMemoryFiles()
+{
+	std::lock_guard lock(mutex);
+	return std::move(memoryFiles);
+}
+
+QString OutputDir::sourceKey(const QString& path) const
+{
+	// Only files on the disk can be referred to by different relative paths
+	if(sourceFS->localPath(path).isEmpty())
+		return QDir::cleanPath(path);
+	return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+}
+
+void OutputDir::registerFile(const QString& relPath, const qint64 size, const QByteArray& digest)
+{
+	std::lock_guard lock(mutex);
+	files[relPath] = {size, digest};
+}
+
+bool OutputDir::makeParentDir(const QString& relPath) const
+{
+	const auto dir = QFileInfo(absolutePath(relPath)).absolutePath();
+	if(QDir().mkpath(dir)) return true;
+	qCritical().noquote() << "Failed to create output directory" << dir;
+	return false;
+}
+
+bool OutputDir::writeFile(const QString& relPath, const QByteArray& data)
+{
+	if(inMemory)
+	{
+		registerFile(relPath, data.size(), QCryptographicHash::hash(data, hashAlgorithm));
+		std::lock_guard lock(mutex);
+		memoryFiles[relPath] = data;
+		return true;
+	}
+	if(!makeParentDir(relPath)) return false;
+
+	const auto path = absolutePath(relPath);
+	QFile file(path);
+	if(!file.open(QFile::WriteOnly))
+	{
+		qCritical().noquote() << "Failed to open file" << path << "for writing:" << file.errorString();
+		return false;
+	}
+	if(file.write(data) != data.size() || !file.flush())
+	{
+		qCritical().noquote() << "Failed to write" << path << ":" << file.errorString();
+		return false;
+	}
+	registerFile(relPath, data.size(), QCryptographicHash::hash(data, hashAlgorithm));
+	return true;
+}
+
+bool OutputDir::copyFile(const QString& sourcePath, const QString& relPath)
+{
+	if(inMemory)
+	{
+		const auto data = sourceFS->readAll(sourcePath);
+		if(!data)
+		{
+			qCritical().noquote() << "Failed to open file" << sourcePath;
+			return false;
+		}
+		if(!writeFile(relPath, *data)) return false;
+		const auto digest = find(relPath)->digest;
+		std::lock_guard lock(mutex);
+		sourceDigests[sourceKey(sourcePath)] = digest;
+		return true;
+	}
+	if(!makeParentDir(relPath)) return false;
+
+	const auto inDevice = sourceFS->open(sourcePath);
+	if(!inDevice)
+	{
+		qCritical().noquote() << "Failed to open file" << sourcePath;
+		return false;
+	}
+	auto& in = *inDevice;
+	const auto path = absolutePath(relPath);
+	QFile out(path);
+	if(!out.open(QFile::WriteOnly | QFile::NewOnly))
+	{
+		qCritical().noquote() << "Failed to open file" << path << "for writing:" << out.errorString();
+		return false;
+	}
+
+	QCryptographicHash hash(hashAlgorithm);
+	qint64 size = 0;
+	QByteArray chunk(copyChunkSize, Qt::Uninitialized);
+	while(!in.atEnd())
+	{
+		const auto count = in.read(chunk.data(), copyChunkSize);
+		if(count < 0)
+		{
+			qCritical().noquote() << "Failed to read" << sourcePath << ":" << in.errorString();
+			out.remove();
+			return false;
+		}
+		hash.addData(QByteArrayView(chunk.constData(), count));
+		if(out.write(chunk.constData(), count) != count)
+		{
+			qCritical().noquote() << "Failed to write" << path << ":" << out.errorString();
+			out.remove();
+			return false;
+		}
+		size += count;
+	}
+	if(!out.flush())
+	{
+		qCritical().noquote() << "Failed to write" << path << ":" << out.errorString();
+		out.remove();
+		return false;
+	}
+	const auto digest = hash.result();
+	registerFile(relPath, size, digest);
+	// We've just hashed the source as well, remember it for subsequent references
+	std::lock_guard lock(mutex);
+	sourceDigests[sourceKey(sourcePath)] = digest;
+	return true;
+}
+
+QByteArray OutputDir::sourceDigest(const QString& sourcePath)
+{
+	const auto key = sourceKey(sourcePath);
+	{
+		std::lock_guard lock(mutex);
+		if(const auto it = sourceDigests.constFind(key); it != sourceDigests.cend())
+			return it.value();
+	}
+	const auto digest = hashFile(*sourceFS, sourcePath);
+	if(!digest.isEmpty())
+	{
+		std::lock_guard lock(mutex);
+		sourceDigests[key] = digest;
+	}
+	return digest;
+}
+
+auto OutputDir::publishFile(const QString& sourcePath, const QString& relPath) -> PublishResult
+{
+	const auto sourceSize = sourceFS->size(sourcePath);
+	if(const auto target = find(relPath))
+	{
+		if(target->size != sourceSize)
+			return PublishResult::Collision;
+		const auto digest = sourceDigest(sourcePath);
+		if(digest.isEmpty())
+			return PublishResult::Failed;
+		return digest == target->digest ? PublishResult::AlreadyPresent : PublishResult::Collision;
+	}
+
+	if(inMemory)
+		return copyFile(sourcePath, relPath) ? PublishResult::Copied : PublishResult::Failed;
+
+	const auto targetPath = absolutePath(relPath);
+	if(const QFileInfo targetInfo(targetPath); targetInfo.exists())
+	{
+		// Not written by us, so we have to hash it to compare
+		if(targetInfo.size() != sourceSize)
+			return PublishResult::Collision;
+		const auto sourceHash = sourceDigest(sourcePath);
+		const auto targetHash = hashFile(FileSystem::disk(), targetPath);
+		if(sourceHash.isEmpty() || targetHash.isEmpty())
+			return PublishResult::Failed;
+		if(sourceHash != targetHash)
+			return PublishResult::Collision;
+		registerFile(relPath, targetInfo.size(), targetHash);
+		return PublishResult::AlreadyPresent;
+	}
+
+	// The blob store can only be filled from files that exist on the disk
+	if(!blobStoreDir.isEmpty() && !sourceFS->localPath(sourcePath).isEmpty())
+		return publishFromBlobStore(sourcePath, relPath) ? PublishResult::Copied : PublishResult::Failed;
+
+	return copyFile(sourcePath, relPath) ? PublishResult::Copied : PublishResult::Failed;
+}
+
+bool OutputDir::publishFromBlobStore(const QString& sourcePath, const QString& relPath)
+{
+	const auto digest = sourceDigest(sourcePath);
+	if(digest.isEmpty()) return false;
+
+	const auto hex = QString::fromLatin1(digest.toHex());
+	const auto blobDir = blobStoreDir + "/" + hex.left(2);
+	const auto blobPath = blobDir + "/" + hex;
+	if(!QFileInfo::exists(blobPath))
+	{
+		if(!QDir().mkpath(blobDir))
+		{
+			qCritical().noquote() << "Failed to create blob store directory" << blobDir;
+			return false;
+		}
+		// Other converter processes may be filling the store concurrently, so
+		// copy to a private temporary file and then atomically rename it.
+		static std::atomic<unsigned> tmpCounter{0};
+		const auto tmpPath = QString("%1.tmp-%2-%3").arg(blobPath).arg(QCoreApplication::applicationPid())
+		                                              .arg(tmpCounter++);
+		QFile::remove(tmpPath);
+		if(!QFile::copy(sourceFS->localPath(sourcePath), tmpPath))
+		{
+			qCritical().noquote() << "Failed to copy" << sourcePath << "to the blob store";
+			return false;
+		}
+		// If the rename fails, someone has put the same blob there before us
+		if(!QFile::rename(tmpPath, blobPath))
+			QFile::remove(tmpPath);
+	}
+
+	if(!makeParentDir(relPath)) return false;
+	const auto targetPath = absolutePath(relPath);
+	if(!linkOrCopy(blobPath, targetPath))
+	{
+		qCritical().noquote() << "Failed to publish" << blobPath << "as" << targetPath;
+		return false;
+	}
+	registerFile(relPath, QFileInfo(blobPath).size(), digest);
+	return true;
+}
+
+bool OutputDir::publishScaledImage(const QString& sourcePath, const QString& relPath, const QSize& scaledSize)
+{
+	const auto format = QFileInfo(relPath).suffix().toLower().toLatin1();
+	const auto digest = sourceDigest(sourcePath);
+	if(digest.isEmpty()) return false;
+
+	QString cachePath;
+	if(!imageCacheDir.isEmpty())
+	{
+		const auto settings = QString("%1x%2 %3 q%4 v%5").arg(scaledSize.width()).arg(scaledSize.height())
+		                          .arg(QString::fromLatin1(format)).arg(jpegQuality).arg(imageEncoderVersion);
+		const auto key = QCryptographicHash::hash(digest + settings.toUtf8(), hashAlgorithm).toHex();
+		cachePath = imageCacheDir + "/" + QString::fromLatin1(key) + "." + QString::fromLatin1(format);
+		if(QFile cached(cachePath); cached.open(QIODevice::ReadOnly))
+			return writeFile(relPath, cached.readAll());
+	}
+
+	const auto sourceDevice = sourceFS->open(sourcePath);
+	if(!sourceDevice)
+	{
+		qCritical().noquote() << "Failed to open file" << sourcePath;
+		return false;
+	}
+	QImageReader reader(sourceDevice.get(), QFileInfo(sourcePath).suffix().toLower().toLatin1());
+	QImage image = reader.read();
+	if(image.isNull())
+	{
+		qCritical().noquote() << "Failed to read image" << sourcePath << ":" << reader.errorString();
+		return false;
+	}
+	image = image.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	QImageWriter writer(&buffer, format);
+	if(format == "jpg" || format == "jpeg")
+		writer.setQuality(jpegQuality);
+	if(!writer.write(image))
+	{
+		qCritical().noquote() << "Failed to encode image" << sourcePath << ":" << writer.errorString();
+		return false;
+	}
+
+	if(!cachePath.isEmpty())
+	{
+		// The cache is only an optimization, so failing to fill it is not an error
+		QSaveFile cacheFile(cachePath);
+		if(!QDir().mkpath(imageCacheDir) || !cacheFile.open(QIODevice::WriteOnly) ||
+		   cacheFile.write(data) != data.size() || !cacheFile.commit())
+			qWarning().noquote() << "Failed to store" << cachePath << "in the image cache";
+	}
+
+	return writeFile(relPath, data);
+}
+
+void OutputDir::publishFileAsync(const QString& sourcePath, const QString& relPath)
+{
+	publishImageAsync(sourcePath, relPath, QSize());
+}
+
+void OutputDir::publishImageAsync(const QString& sourcePath, const QString& relPath, const QSize& scaledSize)
+{
+	const QueuedFile file{sourceKey(sourcePath), scaledSize};
+	QueuedFile first;
+	{
+		std::lock_guard lock(mutex);
+		const auto it = queuedFiles.constFind(relPath);
+		if(it == queuedFiles.cend())
+			queuedFiles.insert(relPath, file);
+		else if(it->source == file.source)
+			return; // Already queued, possibly at another scale, which the first request decides
+		else
+			first = it.value();
+	}
+
+	if(first.source.isEmpty())
+	{
+		publishQueue.push([this, sourcePath, relPath, scaledSize, context = Diagnostics::Context::current()]
+		{
+			Diagnostics::Scope diagnosticsScope(context);
+			if(progress->cancelled())
+				return false;
+			if(scaledSize.isValid())
+			{
+				if(publishScaledImage(sourcePath, relPath, scaledSize))
+					return true;
+				qCritical().noquote() << "Failed to convert image" << sourcePath << "to" << absolutePath(relPath);
+				return false;
+			}
+			switch(publishFile(sourcePath, relPath))
+			{
+			case PublishResult::Copied:
+			case PublishResult::AlreadyPresent:
+				return true;
+			case PublishResult::Collision:
+				qCritical().noquote() << "Image file names collide:" << sourcePath << "and" << absolutePath(relPath);
+				return false;
+			case PublishResult::Failed:
+				break;
+			}
+			qCritical().noquote() << "Failed to copy file" << sourcePath << "to" << absolutePath(relPath);
+			return false;
+		});
+	}
+	else
+	{
+		// Another source file is going to be published at this path, so the
+		// contents of the two sources must be the same to avoid a collision.
+		publishQueue.push([this, sourcePath, relPath, scaledSize, first, context = Diagnostics::Context::current()]
+		{
+			Diagnostics::Scope diagnosticsScope(context);
+			if(progress->cancelled())
+				return false;
+			if(scaledSize == first.scaledSize)
+			{
+				const auto digest = sourceDigest(sourcePath);
+				const auto firstDigest = sourceDigest(first.source);
+				if(digest.isEmpty() || firstDigest.isEmpty())
+					return false;
+				if(digest == firstDigest)
+					return true;
+			}
+			qCritical().noquote() << "Image file names collide:" << sourcePath << "and" << first.source
+			                      << "are both to be published as" << absolutePath(relPath);
+			return false;
+		});
+	}
+}
+
+bool OutputDir::waitForPublishing()
+{
+	return publishQueue.wait();
+}
+
+bool OutputDir::addExistingFile(const QString& relPath)
+{
+	if(inMemory)
+	{
+		qCritical().noquote() << "Can't add existing file" << relPath << "to an in-memory output";
+		return false;
+	}
+	const auto path = absolutePath(relPath);
+	const auto digest = hashFile(FileSystem::disk(), path);
+	if(digest.isEmpty()) return false;
+	registerFile(relPath, QFileInfo(path).size(), digest);
+	return true;
+}
+
+auto OutputDir::find(const QString& relPath) const -> std::optional<FileInfo>
+{
+	std::lock_guard lock(mutex);
+	const auto it = files.find(relPath);
+	if(it == files.end()) return std::nullopt;
+	return it->second;
+}
+
+bool OutputDir::writeManifest()
+{
+	std::unique_lock lock(mutex);
+	QByteArray json = "{\n"
+	                  "  \"hash_algorithm\": \"" + QByteArray(hashAlgorithmName) + "\",\n"
+	                  "  \"files\": [\n";
+	for(auto it = files.begin(); it != files.end(); ++it)
+	{
+		json += "    {\"path\": \"" + jsonEscape(it->first).toUtf8() + "\", "
+		        "\"size\": " + QByteArray::number(it->second.size) + ", "
+		        "\"hash\": \"" + it->second.digest.toHex() + "\"}";
+		json += std::next(it) == files.end() ? "\n" : ",\n";
+	}
+	json += "  ]\n"
+	        "}\n";
+
+	if(inMemory)
+	{
+		memoryFiles[manifestFileName] = json;
+		return true;
+	}
+	lock.unlock();
+
+	const auto path = absolutePath(manifestFileName);
+	QFile file(path);
+	if(!file.open(QFile::WriteOnly) || file.write(json) != json.size() || !file.flush())
+	{
+		qCritical().noquote() << "Failed to write" << path << ":" << file.errorString();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,130 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <QHash>
+#include <QSize>
+#include <QString>
+#include <QByteArray>
+#include "TaskQueue.hpp"
+#include "FileSystem.hpp"
+#include "Progress.hpp"
+
+//! Output directory of a converted sky culture. All the files are written through
+//! this class, so that their sizes and content digests can be listed in manifest.json.
+//! The methods may be called concurrently.
+class OutputDir
+{
+public:
+	struct FileInfo
+	{
+		qint64 size = 0;
+		QByteArray digest;
+	};
+
+	explicit OutputDir(const QString& path);
+	//! Tag for the constructor of an output that is kept in memory rather than written to disk
+	struct InMemory {};
+	explicit OutputDir(InMemory);
+	~OutputDir();
+	bool isInMemory() const { return inMemory; }
+	//! Takes the files written to an in-memory output, keyed by their relative paths
+	std::map<QString, QByteArray> takeMemoryFiles();
+	//! Makes the source files of copyFile() and publishing be read through fs instead of from the disk
+	void setSourceFileSystem(const FileSystem& fs) { sourceFS = &fs; }
+	const QString& path() const { return rootPath; }
+	QString absolutePath(const QString& relPath) const { return rootPath + "/" + relPath; }
+
+	//! Writes data to the file, computing the digest of the data being written
+	bool writeFile(const QString& relPath, const QByteArray& data);
+	//! Copies an external file into the output, computing the digest while copying
+	bool copyFile(const QString& sourcePath, const QString& relPath);
+	//! Registers a file that was written by a third-party library directly. Its
+	//! contents have to be read back to compute the digest. Not possible in memory.
+	bool addExistingFile(const QString& relPath);
+	std::optional<FileInfo> find(const QString& relPath) const;
+
+	enum class PublishResult
+	{
+		Copied,
+		AlreadyPresent, //!< The same contents is already there, nothing to do
+		Collision,      //!< A file with different contents already occupies the target path
+		Failed,
+	};
+	//! Copies sourcePath to relPath unless a file with identical contents has already been placed there
+	PublishResult publishFile(const QString& sourcePath, const QString& relPath);
+	//! Queues publishing of the file to background threads. A second request for the same
+	//! relPath is checked against the first one rather than against the file on disk.
+	void publishFileAsync(const QString& sourcePath, const QString& relPath);
+	//! Like publishFileAsync(), but the image is downscaled to the given size and re-encoded
+	//! in the format implied by the extension of relPath. If the size is invalid, the
+	//! image is published as is. If the same source is already queued for relPath, e.g. as
+	//! constellation art downscaled before the description shows it at full size, it is
+	//! published once at the size of the first request.
+	void publishImageAsync(const QString& sourcePath, const QString& relPath, const QSize& scaledSize);
+	//! Waits for the queued files to be published. Returns false if any of them failed or collided.
+	bool waitForPublishing();
+	//! Digest of a source file. It is cached, so repeated references to the same file cost a lookup.
+	QByteArray sourceDigest(const QString& sourcePath);
+
+	//! Makes publishFile() keep a copy of each published file in a content-addressed store
+	//! in the given directory and publish it from there by a hardlink, a reflink or an
+	//! in-kernel copy, falling back to a plain copy. The store can be shared between
+	//! conversions of many sky cultures, so that identical illustrations occupy disk space once.
+	void setBlobStore(const QString& dir) { blobStoreDir = dir; }
+	//! Keeps the results of image re-encoding in the given directory, keyed by the digest
+	//! of the source and the encoding settings, so that reconversions don't re-encode.
+	void setImageCache(const QString& dir) { imageCacheDir = dir; }
+	//! Makes the queued publishing be skipped, and fail, once the progress is cancelled
+	void setProgress(const Progress& p) { progress = &p; }
+
+	bool writeManifest();
+
+	static constexpr const char* manifestFileName = "manifest.json";
+	static constexpr const char* hashAlgorithmName = "blake2b-256";
+
+private:
+	QString rootPath;
+	const bool inMemory = false;
+	const FileSystem* sourceFS = &FileSystem::disk();
+	const Progress* progress = &Progress::none();
+	mutable std::mutex mutex; // guards the containers below
+	std::map<QString/*relPath*/, FileInfo> files;
+	QHash<QString/*source key*/, QByteArray/*digest*/> sourceDigests;
+	struct QueuedFile
+	{
+		QString source; // as returned by sourceKey()
+		QSize scaledSize;
+	};
+	QHash<QString/*relPath*/, QueuedFile> queuedFiles;
+	std::map<QString/*relPath*/, QByteArray/*contents*/> memoryFiles;
+	QString blobStoreDir;
+	QString imageCacheDir;
+	TaskQueue publishQueue;
+
+	QString sourceKey(const QString& path) const;
+	bool makeParentDir(const QString& relPath) const;
+	void registerFile(const QString& relPath, qint64 size, const QByteArray& digest);
+	bool publishFromBlobStore(const QString& sourcePath, const QString& relPath);
+	bool publishScaledImage(const QString& sourcePath, const QString& relPath, const QSize& scaledSize);
+};
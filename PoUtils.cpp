@@ -0,0 +1,332 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "PoUtils.hpp"
+
+#include <cstring>
+#include <utility>
+#include <QChar>
+#include <QFile>
+#include <QDebug>
+#include <QFileInfo>
+#include <unilbrk.h>
+
+namespace PoUtils
+{
+
+namespace
+{
+
+bool startsWithAt(const QByteArray& data, const qsizetype pos, const char* prefix)
+{
+	const auto len = qsizetype(std::strlen(prefix));
+	return pos + len <= data.size() && std::memcmp(data.constData() + pos, prefix, len) == 0;
+}
+
+qsizetype skipBlanks(const QByteArray& data, qsizetype pos)
+{
+	while(pos < data.size() && (data[pos] == ' ' || data[pos] == '\t'))
+		++pos;
+	return pos;
+}
+
+qsizetype nextLine(const QByteArray& data, const qsizetype pos)
+{
+	const auto newline = data.indexOf('\n', pos);
+	return newline < 0 ? data.size() : newline + 1;
+}
+
+// Skips the obsolete entry marker if needed and the indentation at the beginning of a line
+qsizetype skipLinePrefix(const QByteArray& data, qsizetype pos, const bool obsolete)
+{
+	if(obsolete && startsWithAt(data, pos, "#~"))
+		pos += 2;
+	return skipBlanks(data, pos);
+}
+
+int hexDigitValue(const char c)
+{
+	if('0' <= c && c <= '9') return c - '0';
+	if('a' <= c && c <= 'f') return c - 'a' + 10;
+	if('A' <= c && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+// Reads a C-style quoted string at pos and appends its unescaped contents to out
+bool readQuoted(const QByteArray& data, qsizetype& pos, QByteArray& out)
+{
+	if(pos >= data.size() || data[pos] != '"')
+		return false;
+	++pos;
+	while(pos < data.size())
+	{
+		const char c = data[pos++];
+		if(c == '"') return true;
+		if(c == '\n') return false;
+		if(c != '\\')
+		{
+			out += c;
+			continue;
+		}
+		if(pos >= data.size()) return false;
+		const char e = data[pos++];
+		switch(e)
+		{
+		case 'n': out += '\n'; break;
+		case 't': out += '\t'; break;
+		case 'r': out += '\r'; break;
+		case 'a': out += '\a'; break;
+		case 'b': out += '\b'; break;
+		case 'f': out += '\f'; break;
+		case 'v': out += '\v'; break;
+		case 'x':
+		{
+			int value = 0, digits = 0;
+			for(int d; pos < data.size() && (d = hexDigitValue(data[pos])) >= 0; ++pos, ++digits)
+				value = value * 16 + d;
+			if(!digits) return false;
+			out += char(value);
+			break;
+		}
+		default:
+			if('0' <= e && e <= '7')
+			{
+				int value = e - '0';
+				for(int n = 1; n < 3 && pos < data.size() && '0' <= data[pos] && data[pos] <= '7'; ++n, ++pos)
+					value = value * 8 + (data[pos] - '0');
+				out += char(value);
+			}
+			else
+			{
+				out += e; // \" \\ and the like
+			}
+			break;
+		}
+	}
+	return false;
+}
+
+// Reads the value of a keyword, which may continue on the following lines, and leaves pos at the start of the next line
+bool readValue(const QByteArray& data, qsizetype& pos, const bool obsolete, QByteArray& out)
+{
+	pos = skipBlanks(data, pos);
+	if(!readQuoted(data, pos, out))
+		return false;
+	for(;;)
+	{
+		pos = nextLine(data, pos);
+		const auto next = skipLinePrefix(data, pos, obsolete);
+		if(next >= data.size() || data[next] != '"')
+			return true;
+		pos = next;
+		if(!readQuoted(data, pos, out))
+			return false;
+	}
+}
+
+bool readKeyword(const QByteArray& data, qsizetype& pos, const bool obsolete, const char* keyword, QByteArray& out)
+{
+	pos = skipLinePrefix(data, pos, obsolete);
+	if(!startsWithAt(data, pos, keyword))
+		return false;
+	pos += std::strlen(keyword);
+	return readValue(data, pos, obsolete, out);
+}
+
+Translations scan(const QByteArray& data, const QByteArray& context)
+{
+	Translations translations;
+	const char marker[] = "msgctxt ";
+	for(qsizetype pos = 0; (pos = data.indexOf(marker, pos)) >= 0; )
+	{
+		const auto markerPos = pos;
+		pos += sizeof marker - 1;
+
+		// The keyword must start a line, possibly of an obsolete entry
+		const auto lineStart = data.lastIndexOf('\n', markerPos) + 1;
+		bool obsolete = false;
+		if(skipBlanks(data, lineStart) != markerPos)
+		{
+			if(!startsWithAt(data, lineStart, "#~") || skipLinePrefix(data, lineStart, true) != markerPos)
+				continue;
+			obsolete = true;
+		}
+
+		QByteArray ctxt, msgid, msgstr;
+		if(!readValue(data, pos, obsolete, ctxt) || ctxt != context)
+			continue;
+		// Plural entries have msgid_plural here and are skipped
+		if(!readKeyword(data, pos, obsolete, "msgid ", msgid) || !readKeyword(data, pos, obsolete, "msgstr ", msgstr))
+			continue;
+		auto key = QString::fromUtf8(msgid);
+		if(!translations.contains(key))
+			translations.insert(std::move(key), QString::fromUtf8(msgstr));
+	}
+	return translations;
+}
+
+}
+
+std::shared_ptr<const Translations> contextTranslations(const QString& poFilePath, const QByteArray& context)
+{
+	if(!QFileInfo(poFilePath).isFile())
+		return nullptr;
+
+	QFile file(poFilePath);
+	if(!file.open(QFile::ReadOnly))
+	{
+		qWarning().noquote() << "Failed to open" << poFilePath << ":" << file.errorString();
+		return nullptr;
+	}
+	// Map the file if possible to avoid copying the whole catalog into memory
+	QByteArray data;
+	if(const auto mapped = file.map(0, file.size()))
+		data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), file.size());
+	else
+		data = file.readAll();
+
+	return std::make_shared<const Translations>(scan(data, context));
+}
+
+namespace
+{
+
+// The page width used by gettext. The closing quote and the opening one of continuation lines take a column each.
+constexpr int pageWidth = 79;
+constexpr int stringWidth = pageWidth - 2;
+
+char escapeLetter(const char c)
+{
+	switch(c)
+	{
+	case '\a': return 'a';
+	case '\b': return 'b';
+	case '\f': return 'f';
+	case '\n': return 'n';
+	case '\r': return 'r';
+	case '\t': return 't';
+	case '\v': return 'v';
+	case '\\': return '\\';
+	case '"': return '"';
+	default: return 0;
+	}
+}
+
+}
+
+// This follows wrap() in gettext's write-po.c for the default, non-indented style, and breaks lines with the
+// same libunistring function, so that the result is byte for byte what po_file_write() produces.
+void PoWriter::writeString(const char* keyword, const QByteArray& value)
+{
+	// Handle the value in portions that end after each newline
+	bool firstLine = true;
+	qsizetype portionStart = 0;
+	do
+	{
+		auto portionEnd = value.indexOf('\n', portionStart);
+		portionEnd = portionEnd < 0 ? value.size() : portionEnd + 1;
+
+		// Escape the portion. A break is never allowed inside an escape sequence.
+		QByteArray portion;
+		QByteArray overrides;
+		for(qsizetype pos = portionStart; pos < portionEnd; ++pos)
+		{
+			if(const char letter = escapeLetter(value[pos]))
+			{
+				portion += '\\';
+				portion += letter;
+				overrides += char(UC_BREAK_UNDEFINED);
+				overrides += char(UC_BREAK_PROHIBITED);
+			}
+			else
+			{
+				portion += value[pos];
+				overrides += char(UC_BREAK_UNDEFINED);
+			}
+		}
+		// Don't leave the final "\n" alone on a line
+		if(portionEnd > portionStart && value[portionEnd - 1] == '\n')
+			overrides[overrides.size() - 2] = char(UC_BREAK_PROHIBITED);
+
+		QByteArray breaks(portion.size(), char(UC_BREAK_UNDEFINED));
+		const auto findBreaks = [&](const int startColumn)
+		{
+			if(portion.isEmpty()) return false;
+			u8_width_linebreaks(reinterpret_cast<const uint8_t*>(portion.constData()), portion.size(), stringWidth,
+			                    startColumn, 0, overrides.constData(), "UTF-8", breaks.data());
+			return breaks.contains(char(UC_BREAK_POSSIBLE));
+		};
+		const int keywordColumn = int(std::strlen(keyword)) + 1;
+		const bool wraps = findBreaks(firstLine ? keywordColumn : 0);
+		// A string that doesn't fit on the keyword line starts on the next line
+		if(firstLine && !portion.isEmpty() && (portionEnd < value.size() || keywordColumn > stringWidth || wraps))
+		{
+			buffer += keyword;
+			buffer += " \"\"\n";
+			firstLine = false;
+			findBreaks(0);
+		}
+
+		if(firstLine)
+		{
+			buffer += keyword;
+			buffer += ' ';
+		}
+		buffer += '"';
+		for(qsizetype i = 0; i < portion.size(); ++i)
+		{
+			if(breaks[i] == char(UC_BREAK_POSSIBLE))
+				buffer += "\"\n\"";
+			buffer += portion[i];
+		}
+		buffer += "\"\n";
+
+		portionStart = portionEnd;
+		firstLine = false;
+	}
+	while(portionStart < value.size());
+}
+
+void PoWriter::addMessage(const QString& msgid, const QString& msgstr, const QString& extractedComments)
+{
+	if(!buffer.isEmpty())
+		buffer += '\n';
+	if(!extractedComments.isEmpty())
+	{
+		// Split into lines like po_message_set_extracted_comments() does, ignoring a trailing newline
+		const auto comments = extractedComments.toUtf8();
+		for(qsizetype pos = 0; pos < comments.size(); )
+		{
+			auto end = comments.indexOf('\n', pos);
+			if(end < 0) end = comments.size();
+			buffer += "#.";
+			if(end > pos)
+			{
+				buffer += ' ';
+				buffer.append(comments.constData() + pos, end - pos);
+			}
+			buffer += '\n';
+			pos = end + 1;
+		}
+	}
+	writeString("msgid", msgid.toUtf8());
+	writeString("msgstr", msgstr.toUtf8());
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <memory>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+namespace PoUtils
+{
+
+using Translations = QHash<QString/*msgid*/, QString/*msgstr*/>;
+
+//! Finds the messages with the given context in a UTF-8 PO file, without parsing the rest of
+//! the catalog. If a msgid occurs several times, the first occurrence wins, like when iterating
+//! the messages with libgettextpo. Nothing is cached here: the callers keep the result in their
+//! ConverterContext, so that large catalogs shared by many sky cultures are only scanned once.
+//! Returns nullptr if the file can't be read.
+std::shared_ptr<const Translations> contextTranslations(const QString& poFilePath, const QByteArray& context);
+
+//! Serializes messages the way po_file_write() of libgettextpo lays them out, including the
+//! wrapping of strings at 79 columns, but straight into a buffer without building a catalog.
+//! Lines are broken by libunistring like gettext does it, so the output is identical to that of
+//! po_file_write() for UTF-8 catalogs.
+class PoWriter
+{
+public:
+	//! Appends a message. Each line of extractedComments becomes a "#." comment.
+	void addMessage(const QString& msgid, const QString& msgstr, const QString& extractedComments = {});
+	const QByteArray& data() const { return buffer; }
+private:
+	void writeString(const char* keyword, const QByteArray& value);
+	QByteArray buffer;
+};
+
+}
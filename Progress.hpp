@@ -0,0 +1,70 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <QString>
+
+//! Lets a conversion running in one thread be stopped from another one. The conversion
+//! checks the token between records, files and locales, and then gives up.
+class CancellationToken
+{
+public:
+	void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+	bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<bool> cancelled{false};
+};
+
+//! Receives the stage of the conversion (e.g. "names"), the item being processed in it (e.g. a
+//! file name or a locale), and how many of the items of the stage are done out of total. A zero
+//! total means that the number of items is not known.
+using ProgressCallback = std::function<void(const QString& stage, const QString& item, int done, int total)>;
+
+//! Where the loaders report their progress and check whether they should stop
+class Progress
+{
+public:
+	Progress() = default;
+	Progress(ProgressCallback callback, const CancellationToken* token)
+		: callback(std::move(callback))
+		, token(token)
+	{
+	}
+
+	void report(const QString& stage, const QString& item, const int done, const int total) const
+	{
+		if(callback) callback(stage, item, done, total);
+	}
+	bool cancelled() const { return token && token->isCancelled(); }
+
+	//! Progress that goes nowhere and is never cancelled
+	static const Progress& none()
+	{
+		static const Progress progress;
+		return progress;
+	}
+
+private:
+	ProgressCallback callback;
+	const CancellationToken* token = nullptr;
+};
@@ -0,0 +1,197 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "Regex.hpp"
+
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <QDebug>
+#include <QElapsedTimer>
+
+namespace Regex
+{
+
+namespace
+{
+
+std::atomic<bool> profiling{false};
+
+struct Definition
+{
+	Id id;
+	const char* name;
+	const char* pattern;
+	QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+};
+
+const Definition definitions[] = {
+	{FabCommentLine, "FabCommentLine", "^(\\s*#.*|\\s*)$"},
+	{CommentHashPrefix, "CommentHashPrefix", "^#\\s*"},
+	{TranslationContext, "TranslationContext", "(.*)\",\\s*\"(.*)"},
+	{AsterismNameRecord, "AsterismNameRecord", "^\\s*(\\S+)\\s+_[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)\\n"},
+	{SeasonalRuleRecord, "SeasonalRuleRecord", "^\\s*(\\w+)\\s+(\\w+)\\s+(\\w+)\\n"},
+	{ConstellationNameRecord, "ConstellationNameRecord", "^\\s*(\\.?\\S+)\\s+\"(.*)\"\\s+_[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)\\n"},
+	{StarNameRecord, "StarNameRecord", "^\\s*(\\d+)\\s*\\|(_*)[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)"},
+	{DSONameRecord, "DSONameRecord", "^\\s*([\\w\\s\\-\\+\\.]+)\\s*\\|(_*)[(]\"(.*)\"[)]\\s*([\\,\\d\\s]*)"},
+	{PlanetNameRecord, "PlanetNameRecord", "^\\s*(\\w+)\\s+\"(.+)\"\\s+_[(]\"(.+)\"[)](?:\\n|$)"},
+	{ReferenceFieldSeparator, "ReferenceFieldSeparator", "\\|"},
+	{LicenseSuffix, "LicenseSuffix", "(?: International)?(?: Publice?)? License"},
+
+	{HTMLComment, "HTMLComment", "<!--.*?-->"},
+	{HTMLGeneralImage, "HTMLGeneralImage", R"reg(<img\b[^>/]*\s+src="([^"]+)"[^>/]*/?>)reg"},
+	{FootnoteId, "FootnoteId", "^footnote-([0-9]+)$"},
+	{FootnoteHref, "FootnoteHref", "^#footnote-([0-9]+)$"},
+	{DescriptionLocale, "DescriptionLocale", "description\\.([^.]+)\\.utf8"},
+	{NotrElement, "NotrElement", "<notr>([^<]+)</notr>"},
+
+	{RepeatedBlankLines, "RepeatedBlankLines", "\n[ \t]*\n[ \t]*\n+"},
+	{RepeatedBlankQuoteLines, "RepeatedBlankQuoteLines", "\n>[ \t]*(?:\n>[ \t]*)+\n"},
+	{TrailingSpaces, "TrailingSpaces", "[ \t]+\n"},
+	{SparseUnorderedList, "SparseUnorderedList", "(\n -[^\n]+)\n+(\n \\-)"},
+	{SparseOrderedList, "SparseOrderedList", "(\n 1\\.[^\n]+)\n+(\n 1)"},
+	{IntroductionAfterTitle, "IntroductionAfterTitle", "^\\s*# [^\n]+\n+\\s*##\\s*Introduction\n"},
+	{TextAfterTitle, "TextAfterTitle", "^(\\s*# [^\n]+\n+)(\\s*[^#])"},
+	{IntroductionWithoutDescription, "IntroductionWithoutDescription", "(\n## Introduction\n[^#]+\n)(\\s*#)"},
+	{ReferencesHeading, "ReferencesHeading", "\n##\\s+(?:References|External\\s+links)\\s*\n"},
+	{ExternalLinksHeading, "ExternalLinksHeading", "(\n##[ \t]+)External[ \t]+links([ \t]*\n)"},
+	{AuthorsHeading, "AuthorsHeading", "(\n##\\s+Authors?\\s*\n)"},
+	{LicenseHeading, "LicenseHeading", "\n##\\s+License\\s*\n"},
+	{SectionHeader, "SectionHeader", "^[ \t]*((#+)\\s+(.*[^\\s])\\s*)$", QRegularExpression::MultilineOption},
+	{Level1Heading, "Level1Heading", "^# +(.+)$", QRegularExpression::MultilineOption},
+	{Level2Heading, "Level2Heading", "^## +(.+)$", QRegularExpression::MultilineOption},
+	{SurroundingNewlines, "SurroundingNewlines", "^\n*|\n*$"},
+};
+static_assert(std::size(definitions) == IdCount, "Each pattern must have a definition");
+
+// Measures the time spent in a pattern if profiling is enabled
+class Measurement
+{
+public:
+	Measurement()
+	{
+		if(profiling.load(std::memory_order_relaxed))
+			timer.start();
+	}
+	bool isActive() const { return timer.isValid(); }
+	qint64 elapsed() const { return timer.nsecsElapsed(); }
+private:
+	QElapsedTimer timer;
+};
+
+}
+
+Pattern::Pattern(const char* name, const char* pattern, const QRegularExpression::PatternOptions options)
+	: patternName(name)
+	, re(QString::fromUtf8(pattern), options)
+{
+	if(!re.isValid())
+		qCritical() << "Invalid regular expression" << name << ":" << re.errorString();
+	re.optimize();
+}
+
+void Pattern::record(const qint64 elapsed, const bool matched) const
+{
+	calls.fetch_add(1, std::memory_order_relaxed);
+	if(matched)
+		hits.fetch_add(1, std::memory_order_relaxed);
+	nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+}
+
+QRegularExpressionMatch Pattern::match(const QString& subject) const
+{
+	const Measurement measurement;
+	auto result = re.match(subject);
+	if(measurement.isActive())
+		record(measurement.elapsed(), result.hasMatch());
+	return result;
+}
+
+QRegularExpressionMatchIterator Pattern::globalMatch(const QString& subject) const
+{
+	// The iterator finds the first match right away, the rest is found while
+	// iterating, so only the first match is included in the time.
+	const Measurement measurement;
+	auto result = re.globalMatch(subject);
+	if(measurement.isActive())
+		record(measurement.elapsed(), result.hasNext());
+	return result;
+}
+
+QString& Pattern::replaceIn(QString& subject, const QString& after) const
+{
+	const Measurement measurement;
+	if(!measurement.isActive())
+		return subject.replace(re, after);
+
+	// QString::replace() leaves the data untouched when nothing matches, so a
+	// shallow copy tells whether there was a match.
+	const QString original = subject;
+	subject.replace(re, after);
+	record(measurement.elapsed(), original.constData() != subject.constData());
+	return subject;
+}
+
+const Pattern& get(const Id id)
+{
+	static const auto patterns = []
+	{
+		std::vector<std::unique_ptr<Pattern>> patterns;
+		patterns.reserve(IdCount);
+		for(const auto& def : definitions)
+		{
+			Q_ASSERT(def.id == Id(patterns.size()));
+			patterns.push_back(std::make_unique<Pattern>(def.name, def.pattern, def.options));
+		}
+		return patterns;
+	}();
+	return *patterns[id];
+}
+
+void setProfilingEnabled(const bool enabled)
+{
+	profiling = enabled;
+}
+
+bool profilingEnabled()
+{
+	return profiling;
+}
+
+void printProfile()
+{
+	std::vector<const Pattern*> used;
+	for(int id = 0; id < IdCount; ++id)
+	{
+		const auto& pattern = get(Id(id));
+		if(pattern.callCount())
+			used.push_back(&pattern);
+	}
+	std::sort(used.begin(), used.end(), [](auto* a, auto* b){ return a->elapsedNS() > b->elapsedNS(); });
+
+	qDebug().noquote() << "Regular expression profile (pattern: calls, matches, time):";
+	for(const auto* pattern : used)
+	{
+		qDebug().noquote().nospace() << "  " << pattern->name() << ": " << pattern->callCount() << ", "
+		                             << pattern->matchCount() << ", " << pattern->elapsedNS() / 1e6 << " ms";
+	}
+}
+
+}
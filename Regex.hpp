@@ -0,0 +1,115 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <QString>
+#include <QRegularExpression>
+
+//! The regular expressions used by the converter. They are compiled and optimized
+//! once, and can optionally count their uses and the time spent in them.
+namespace Regex
+{
+
+enum Id
+{
+	// Legacy .fab files
+	FabCommentLine,
+	CommentHashPrefix,
+	TranslationContext,
+	AsterismNameRecord,
+	SeasonalRuleRecord,
+	ConstellationNameRecord,
+	StarNameRecord,
+	DSONameRecord,
+	PlanetNameRecord,
+	ReferenceFieldSeparator,
+	LicenseSuffix,
+
+	// HTML descriptions
+	HTMLComment,
+	HTMLGeneralImage,
+	FootnoteId,
+	FootnoteHref,
+	DescriptionLocale,
+	NotrElement,
+
+	// Markdown descriptions
+	RepeatedBlankLines,
+	RepeatedBlankQuoteLines,
+	TrailingSpaces,
+	SparseUnorderedList,
+	SparseOrderedList,
+	IntroductionAfterTitle,
+	TextAfterTitle,
+	IntroductionWithoutDescription,
+	ReferencesHeading,
+	ExternalLinksHeading,
+	AuthorsHeading,
+	LicenseHeading,
+	SectionHeader,
+	Level1Heading,
+	Level2Heading,
+	SurroundingNewlines,
+
+	IdCount
+};
+
+class Pattern
+{
+public:
+	Pattern(const char* name, const char* pattern, QRegularExpression::PatternOptions options);
+	Pattern(const Pattern&) = delete;
+	Pattern& operator=(const Pattern&) = delete;
+
+	QRegularExpressionMatch match(const QString& subject) const;
+	QRegularExpressionMatchIterator globalMatch(const QString& subject) const;
+	bool matches(const QString& subject) const { return match(subject).hasMatch(); }
+	//! Replaces all the matches in subject in place, like QString::replace()
+	QString& replaceIn(QString& subject, const QString& after) const;
+	QString replaced(QString subject, const QString& after) const { return std::move(replaceIn(subject, after)); }
+	//! For the APIs that take a QRegularExpression directly. Such uses are not counted.
+	const QRegularExpression& regex() const { return re; }
+
+	const char* name() const { return patternName; }
+	qint64 callCount() const { return calls; }
+	qint64 matchCount() const { return hits; }
+	qint64 elapsedNS() const { return nanoseconds; }
+
+private:
+	void record(qint64 elapsed, bool matched) const;
+
+	const char* patternName;
+	QRegularExpression re;
+	mutable std::atomic<qint64> calls{0};
+	mutable std::atomic<qint64> hits{0};
+	mutable std::atomic<qint64> nanoseconds{0};
+};
+
+const Pattern& get(Id id);
+
+//! Makes the patterns count their uses, matches and the time spent in them
+void setProfilingEnabled(bool enabled);
+bool profilingEnabled();
+//! Prints the counters of the patterns that were used, the most time-consuming first
+void printProfile();
+
+}
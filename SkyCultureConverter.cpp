@@ -19,6 +19,11 @@
 
 #include "SkyCultureConverter.hpp"
 #include "Utils.hpp"
+#include "Regex.hpp"
+#include "OutputDir.hpp"
+#include "FileSystem.hpp"
+#include "TarArchive.hpp"
+#include "IndexJson.hpp"
 #include "NamesOldLoader.hpp"
 #include "AsterismOldLoader.hpp"
 #include "DescriptionOldLoader.hpp"
@@ -28,10 +33,13 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
 #include <QSettings>
-#include <QRegularExpression>
-#include <fstream>
-#include <iostream>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
 #include <sstream>
 
 namespace
@@ -47,7 +55,7 @@ QString convertLicense(const QString &license)
         if (lic.startsWith("Free Art "))
             continue;
 
-        lic.replace(QRegularExpression("(?: International)?(?: Publice?)? License"), "");
+        Regex::get(Regex::LicenseSuffix).replaceIn(lic, "");
     }
 
     if (parts.size() == 1)
@@ -59,20 +67,33 @@ QString convertLicense(const QString &license)
         else if (parts[0].startsWith("Free Art ") && !parts[1].startsWith("Free Art "))
             return "Text and data: " + parts[1] + "\n\nIllustrations: " + parts[0];
     }
-    std::cerr << "SkyCultureConverter::\tUnexpected combination of licenses, leaving them unformatted.\n";
+    Diagnostics::warning("license-format", "Unexpected combination of licenses, leaving them unformatted.");
     return license;
 }
 
-void convertInfoIni(const QString &dir, std::ostream &s, QString &boundariesType, QString &author, QString &credit, QString &license, QString &cultureId, QString &region, QString &englishName)
+void convertInfoIni(const FileSystem &fs, const QString &dir, std::ostream &s, QString &boundariesType, QString &author, QString &credit, QString &license, QString &cultureId, QString &region, QString &englishName)
 {
-    QSettings pd(dir + "/info.ini", QSettings::IniFormat); // FIXME: do we really need StelIniFormat here instead?
-    englishName = pd.value("info/name").toString();
-    author = pd.value("info/author").toString();
-    credit = pd.value("info/credit").toString();
-    license = pd.value("info/license", "").toString();
-    region = pd.value("info/region", "???").toString();
-    const auto classification = pd.value("info/classification").toString();
-    boundariesType = pd.value("info/boundaries", "none").toString();
+    const auto iniPath = dir + "/info.ini";
+    std::unique_ptr<QSettings> settings;
+    QHash<QString, QString> memoryValues;
+    if (const auto localPath = fs.localPath(iniPath); !localPath.isEmpty())
+        settings = std::make_unique<QSettings>(localPath, QSettings::IniFormat); // FIXME: do we really need StelIniFormat here instead?
+    else
+        memoryValues = parseIni(fs.readAll(iniPath).value_or(QByteArray()));
+    const auto value = [&](const QString &key, const QString &defaultValue = QString())
+    {
+        if (settings)
+            return settings->value(key, defaultValue).toString();
+        return memoryValues.value(key, defaultValue);
+    };
+
+    englishName = value("info/name");
+    author = value("info/author");
+    credit = value("info/credit");
+    license = value("info/license", "");
+    region = value("info/region", "???");
+    const auto classification = value("info/classification");
+    boundariesType = value("info/boundaries", "none");
 
     cultureId = QFileInfo(dir).fileName();
 
@@ -87,96 +108,465 @@ void convertInfoIni(const QString &dir, std::ostream &s, QString &boundariesType
                                             "  \"fallback_to_international_names\": false,\n";
 }
 
-void writeEnding(std::string &s)
-{
-    if (s.size() > 2 && s.substr(s.size() - 2) == ",\n")
-        s.resize(s.size() - 2);
-    s += "\n}\n";
-}
-
 }
 
 namespace SkyCultureConverter
 {
 
-ReturnValue convert(
-    const QString &inputDir,
-    const QString &outputDir,
-    const QString &poDir,
-    const QString &nativeLocale,
-    bool footnotesToRefs,
-    bool genTranslatedMD,
-    bool convertUntranslatableNamesToNative)
+namespace
 {
-    // Ensure output does not already exist
-    if (QFile(outputDir).exists())
+
+// The part of the conversion shared by the on-disk and the in-memory variants. The input is
+// read from inDir through fs, and the output directory must already exist if it's on disk.
+ReturnValue convertTree(
+    const FileSystem &fs,
+    const QString &inDir,
+    OutputDir &output,
+    ConverterContext &context,
+    const ConvertOptions &options)
+{
+    const Progress progress(options.progress, options.cancellation);
+    const auto enterStage = [&progress](const QString &stage, const QString &description)
     {
-        std::cerr << "SkyCultureConverter::\tOutput directory already exists, won't touch it.\n";
-        return ReturnValue::ERR_OUTPUT_DIR_EXISTS;
-    }
-    // Check for info.ini in input
-    if (!QFile(inputDir + "/info.ini").exists())
+        Diagnostics::setStage(stage);
+        Diagnostics::info("progress", description);
+        progress.report(stage, {}, 0, 0);
+    };
+    const auto cancelled = [&progress]
     {
-        std::cerr << "SkyCultureConverter::\tError: info.ini file wasn't found\n";
-        return ReturnValue::ERR_INFO_INI_NOT_FOUND;
-    }
-
-    // Normalize input path
-    QString inDir = QDir::fromNativeSeparators(inputDir);
-    while (inDir.endsWith("/"))
-        inDir.chop(1);
+        if (!progress.cancelled())
+            return false;
+        Diagnostics::info("cancelled", "Conversion cancelled");
+        return true;
+    };
 
     // Read basic info
+    enterStage("info", "Reading info.ini");
     std::stringstream out;
     QString boundariesType, author, credit, license, cultureId, region, englishName;
-    convertInfoIni(inDir, out, boundariesType, author, credit, license,
+    convertInfoIni(fs, inDir, out, boundariesType, author, credit, license,
                     cultureId, region, englishName);
 
+    output.setSourceFileSystem(fs);
+    output.setProgress(progress);
+
     // Load data
+    enterStage("asterisms", "Loading asterisms");
     AsterismOldLoader aLoader;
+    aLoader.setFileSystem(fs);
+    aLoader.setProgress(progress);
     aLoader.load(inDir, cultureId);
+    if (cancelled())
+        return ReturnValue::ERR_CANCELLED;
 
+    enterStage("constellations", "Loading constellations");
     ConstellationOldLoader cLoader;
+    cLoader.setFileSystem(fs);
+    cLoader.setProgress(progress);
+    cLoader.setContext(context);
     cLoader.setBoundariesType(boundariesType.toStdString());
-    cLoader.load(inDir, outputDir, nativeLocale);
+    cLoader.setMaxTextureSize(options.maxTextureSize);
+    if (!options.genericBoundariesFile.isEmpty())
+        cLoader.setGenericBoundariesFile(options.genericBoundariesFile);
+    cLoader.load(inDir, output, options.nativeLocale);
+    if (cancelled())
+        return ReturnValue::ERR_CANCELLED;
+    if (cLoader.lacksGenericBoundaries())
+        return ReturnValue::ERR_BOUNDARIES_NOT_FOUND;
 
+    enterStage("names", "Loading names");
     NamesOldLoader nLoader;
-    nLoader.load(inDir, nativeLocale, convertUntranslatableNamesToNative);
+    nLoader.setFileSystem(fs);
+    nLoader.setProgress(progress);
+    nLoader.load(inDir, options.nativeLocale, options.convertUntranslatableNamesToNative);
+    if (cancelled())
+        return ReturnValue::ERR_CANCELLED;
 
-    aLoader.dumpJSON(out);
-    cLoader.dumpJSON(out);
-    nLoader.dumpJSON(out);
+    // Serialize the sections in parallel, each into its own buffer, and join them in a fixed order
+    enterStage("index", "Writing index.json");
+    auto asterisms = dumpSectionAsync(aLoader);
+    auto constellations = dumpSectionAsync(cLoader);
+    auto names = dumpSectionAsync(nLoader);
+    std::vector<std::string> sections;
+    sections.push_back(std::move(out).str());
+    sections.push_back(asterisms.get());
+    sections.push_back(constellations.get());
+    sections.push_back(names.get());
 
     // Finalize and write JSON
-    auto str = std::move(out).str();
-    writeEnding(str);
+    const auto str = joinSections(sections);
 
-    if (!QDir().mkpath(outputDir))
-    {
-        std::cerr << "SkyCultureConverter::\tFailed to create output directory\n";
-        return ReturnValue::ERR_OUTPUT_DIR_CREATION_FAILED;
-    }
+    if (!output.writeFile("index.json", QByteArray::fromRawData(str.data(), str.size())))
     {
-        std::ofstream outFile((outputDir + "/index.json").toStdString());
-        outFile << str;
-        outFile.flush();
-        if (!outFile)
-        {
-            std::cerr << "SkyCultureConverter::\tFailed to write index.json\n";
-            return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
-        }
+        Diagnostics::error("write-failed", "Failed to write index.json");
+        return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
     }
 
     // Description loader
+    enterStage("description", "Converting the descriptions");
     DescriptionOldLoader dLoader;
+    dLoader.setFileSystem(fs);
+    dLoader.setProgress(progress);
+    dLoader.setContext(context);
+    dLoader.setNativePoWriter(options.nativePoWriter);
+    if (!options.markdownCacheDir.isEmpty())
+        dLoader.setMarkdownCache(options.markdownCacheDir);
     license = convertLicense(license);
-    dLoader.load(inDir, poDir, cultureId, englishName,
+    dLoader.load(inDir, options.poDir, cultureId, englishName,
                     author, credit, license,
                     cLoader, aLoader, nLoader,
-                    footnotesToRefs, genTranslatedMD);
-    dLoader.dump(outputDir);
+                    options.footnotesToRefs, options.genTranslatedMD);
+    if (cancelled())
+        return ReturnValue::ERR_CANCELLED;
+    enterStage("output", "Writing the description and the translations");
+    if (!dLoader.dump(output))
+    {
+        if (cancelled())
+            return ReturnValue::ERR_CANCELLED;
+        Diagnostics::error("write-failed", "Failed to write the description or translations");
+        return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
+    }
+
+    // Illustrations are copied in the background while the rest is converted
+    enterStage("illustrations", "Waiting for the illustrations to be published");
+    if (!output.waitForPublishing())
+    {
+        if (cancelled())
+            return ReturnValue::ERR_CANCELLED;
+        Diagnostics::error("write-failed", "Failed to copy some of the illustrations");
+        return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
+    }
+    if (cancelled())
+        return ReturnValue::ERR_CANCELLED;
+
+    enterStage("manifest", QString("Writing %1").arg(OutputDir::manifestFileName));
+    if (!output.writeManifest())
+    {
+        Diagnostics::error("write-failed", QString("Failed to write %1").arg(OutputDir::manifestFileName));
+        return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
+    }
 
     return ReturnValue::CONVERT_SUCCESS;
 }
 
-}
\ No newline at end of file
+// A fresh directory name next to outputDir, unique within the machine for the lifetime of the process
+QString stagingDirFor(const QString &outputDir)
+{
+    static std::atomic<unsigned> counter{0};
+    return QString("%1.tmp-%2-%3").arg(QDir::cleanPath(outputDir))
+                                  .arg(QCoreApplication::applicationPid())
+                                  .arg(counter++);
+}
+
+// Converts the sky culture in inDir of fs into a new directory at outputDir
+ReturnValue convertToDirectory(
+    const FileSystem &fs,
+    const QString &inDir,
+    const QString &outputDir,
+    ConverterContext &context,
+    const ConvertOptions &options)
+{
+    // Ensure output does not already exist
+    if (QFile(outputDir).exists())
+    {
+        Diagnostics::error("output-exists", "Output directory already exists, won't touch it.", QDir::toNativeSeparators(outputDir));
+        return ReturnValue::ERR_OUTPUT_DIR_EXISTS;
+    }
+    // Check for info.ini in input
+    if (!fs.exists(inDir + "/info.ini"))
+    {
+        Diagnostics::error("missing-info-ini", "info.ini file wasn't found");
+        return ReturnValue::ERR_INFO_INI_NOT_FOUND;
+    }
+
+    // The output is assembled in a staging directory and only moved into place when complete,
+    // so that a failed or cancelled conversion doesn't leave a partial sky culture behind
+    const QString stagingDir = stagingDirFor(outputDir);
+    if (!QDir().mkpath(stagingDir))
+    {
+        Diagnostics::error("mkdir-failed", "Failed to create output directory", QDir::toNativeSeparators(stagingDir));
+        return ReturnValue::ERR_OUTPUT_DIR_CREATION_FAILED;
+    }
+
+    ReturnValue ret;
+    {
+        // All the files written into stagingDir get registered here to be listed in the manifest
+        OutputDir output(stagingDir);
+        if (!options.blobStoreDir.isEmpty())
+            output.setBlobStore(options.blobStoreDir);
+        if (!options.imageCacheDir.isEmpty())
+            output.setImageCache(options.imageCacheDir);
+
+        ret = convertTree(fs, inDir, output, context, options);
+        // Leaving the scope waits for the publishing tasks still writing into stagingDir
+    }
+
+    if (ret == ReturnValue::CONVERT_SUCCESS && !QDir().rename(stagingDir, outputDir))
+    {
+        Diagnostics::error("rename-failed", QString("Failed to move the output into place from %1")
+                                                .arg(QDir::toNativeSeparators(stagingDir)),
+                           QDir::toNativeSeparators(outputDir));
+        ret = ReturnValue::ERR_OUTPUT_DIR_CREATION_FAILED;
+    }
+    if (ret != ReturnValue::CONVERT_SUCCESS)
+        QDir(stagingDir).removeRecursively();
+    return ret;
+}
+
+// Converts the sky culture in inDir of fs into a new tar archive at outputPath, with the files under
+// a top-level directory named cultureId. The archive is written only after a successful conversion.
+ReturnValue convertToArchive(
+    const FileSystem &fs,
+    const QString &inDir,
+    const QString &cultureId,
+    const QString &outputPath,
+    ConverterContext &context,
+    const ConvertOptions &options)
+{
+    if (QFile(outputPath).exists())
+    {
+        Diagnostics::error("output-exists", "Output archive already exists, won't touch it.", QDir::toNativeSeparators(outputPath));
+        return ReturnValue::ERR_OUTPUT_DIR_EXISTS;
+    }
+    if (!fs.exists(inDir + "/info.ini"))
+    {
+        Diagnostics::error("missing-info-ini", "info.ini file wasn't found");
+        return ReturnValue::ERR_INFO_INI_NOT_FOUND;
+    }
+
+    // The blob store links files into an output directory, so it doesn't apply here
+    ConvertOptions archiveOptions = options;
+    archiveOptions.blobStoreDir.clear();
+    OutputDir output{OutputDir::InMemory{}};
+    if (!archiveOptions.imageCacheDir.isEmpty())
+        output.setImageCache(archiveOptions.imageCacheDir);
+    const auto ret = convertTree(fs, inDir, output, context, archiveOptions);
+    if (ret != ReturnValue::CONVERT_SUCCESS)
+        return ret;
+
+    const Progress progress(options.progress, options.cancellation);
+    Diagnostics::setStage("archive");
+    Diagnostics::info("progress", QString("Writing %1").arg(QDir::toNativeSeparators(outputPath)));
+    const auto files = output.takeMemoryFiles();
+    QSaveFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        Diagnostics::error("write-failed", "Failed to create the archive: " + file.errorString(), QDir::toNativeSeparators(outputPath));
+        return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
+    }
+    TarArchive::Writer writer(file, TarArchive::isCompressedPath(outputPath));
+    int done = 0;
+    for (const auto &[path, data] : files)
+    {
+        if (progress.cancelled())
+        {
+            Diagnostics::info("cancelled", "Conversion cancelled");
+            file.cancelWriting();
+            return ReturnValue::ERR_CANCELLED;
+        }
+        progress.report("archive", path, done++, int(files.size()));
+        if (!writer.addFile(cultureId + "/" + path, data))
+        {
+            Diagnostics::error("write-failed", "Failed to write " + path + " into the archive: " + file.errorString(),
+                               QDir::toNativeSeparators(outputPath));
+            file.cancelWriting();
+            return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
+        }
+    }
+    if (!writer.finish() || !file.commit())
+    {
+        Diagnostics::error("write-failed", "Failed to write the archive: " + file.errorString(), QDir::toNativeSeparators(outputPath));
+        return ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED;
+    }
+    return ReturnValue::CONVERT_SUCCESS;
+}
+
+// The name of the archive without its extensions, e.g. "western" for "western.tar.gz"
+QString archiveBaseName(const QString &path)
+{
+    QString name = QFileInfo(path).fileName();
+    for (const char *suffix : {".gz", ".tgz", ".tar"})
+    {
+        if (name.endsWith(suffix, Qt::CaseInsensitive))
+            name.chop(qstrlen(suffix));
+    }
+    return name;
+}
+
+}
+
+ReturnValue convert(ConverterContext &context, const QString &inputDir, const QString &outputDir,
+                    const ConvertOptions &options)
+{
+    // Normalize input path
+    QString inDir = QDir::fromNativeSeparators(inputDir);
+    while (inDir.endsWith("/"))
+        inDir.chop(1);
+
+    // The reports are tagged with the culture ID, which is the name of the input directory
+    std::optional<Diagnostics::Scope> diagnosticsScope;
+    if (options.diagnostics)
+        diagnosticsScope.emplace(Diagnostics::Context{options.diagnostics, QFileInfo(inDir).fileName(), {}});
+
+    return convertToDirectory(FileSystem::disk(), inDir, outputDir, context, options);
+}
+
+ReturnValue convert(const QString &inputDir, const QString &outputDir, const ConvertOptions &options)
+{
+    ConverterContext context;
+    return convert(context, inputDir, outputDir, options);
+}
+
+ReturnValue convert(
+    const QString &inputDir,
+    const QString &outputDir,
+    const QString &poDir,
+    const QString &nativeLocale,
+    bool footnotesToRefs,
+    bool genTranslatedMD,
+    bool convertUntranslatableNamesToNative,
+    const QString &blobStoreDir,
+    int maxTextureSize,
+    const QString &imageCacheDir,
+    bool nativePoWriter,
+    const QString &markdownCacheDir,
+    Diagnostics::Collector *diagnostics)
+{
+    ConvertOptions options;
+    options.poDir = poDir;
+    options.nativeLocale = nativeLocale;
+    options.footnotesToRefs = footnotesToRefs;
+    options.genTranslatedMD = genTranslatedMD;
+    options.convertUntranslatableNamesToNative = convertUntranslatableNamesToNative;
+    options.blobStoreDir = blobStoreDir;
+    options.maxTextureSize = maxTextureSize;
+    options.imageCacheDir = imageCacheDir;
+    options.nativePoWriter = nativePoWriter;
+    options.markdownCacheDir = markdownCacheDir;
+    options.diagnostics = diagnostics;
+    return convert(inputDir, outputDir, options);
+}
+
+ReturnValue convertInMemory(
+    ConverterContext &context,
+    const QString &cultureId,
+    const FileMap &inputFiles,
+    FileMap &outputFiles,
+    const ConvertOptions &options)
+{
+    std::optional<Diagnostics::Scope> diagnosticsScope;
+    if (options.diagnostics)
+        diagnosticsScope.emplace(Diagnostics::Context{options.diagnostics, cultureId, {}});
+
+    outputFiles.clear();
+    if (!inputFiles.contains("info.ini"))
+    {
+        Diagnostics::error("missing-info-ini", "info.ini file wasn't found");
+        return ReturnValue::ERR_INFO_INI_NOT_FOUND;
+    }
+
+    // The caches and stores live on the disk, so they don't apply here
+    ConvertOptions memoryOptions = options;
+    memoryOptions.blobStoreDir.clear();
+    memoryOptions.imageCacheDir.clear();
+    memoryOptions.markdownCacheDir.clear();
+    memoryOptions.nativePoWriter = false;
+
+    // The culture ID is taken from the name of the input directory, so the files are rooted at it
+    const MemoryFileSystem fs(cultureId, inputFiles);
+    OutputDir output{OutputDir::InMemory{}};
+    const auto ret = convertTree(fs, cultureId, output, context, memoryOptions);
+    if (ret == ReturnValue::CONVERT_SUCCESS)
+        outputFiles = output.takeMemoryFiles();
+    return ret;
+}
+
+ReturnValue convertInMemory(
+    const QString &cultureId,
+    const FileMap &inputFiles,
+    FileMap &outputFiles,
+    const ConvertOptions &options)
+{
+    ConverterContext context;
+    return convertInMemory(context, cultureId, inputFiles, outputFiles, options);
+}
+
+ReturnValue convertInMemory(
+    const QString &cultureId,
+    const FileMap &inputFiles,
+    FileMap &outputFiles,
+    const QString &poDir,
+    const QString &nativeLocale,
+    bool footnotesToRefs,
+    bool genTranslatedMD,
+    bool convertUntranslatableNamesToNative,
+    int maxTextureSize,
+    Diagnostics::Collector *diagnostics)
+{
+    ConvertOptions options;
+    options.poDir = poDir;
+    options.nativeLocale = nativeLocale;
+    options.footnotesToRefs = footnotesToRefs;
+    options.genTranslatedMD = genTranslatedMD;
+    options.convertUntranslatableNamesToNative = convertUntranslatableNamesToNative;
+    options.maxTextureSize = maxTextureSize;
+    options.diagnostics = diagnostics;
+    return convertInMemory(cultureId, inputFiles, outputFiles, options);
+}
+
+ReturnValue convertArchive(
+    ConverterContext &context,
+    const QString &inputPath,
+    const QString &outputPath,
+    bool outputTar,
+    const ConvertOptions &options)
+{
+    const bool inputTar = TarArchive::isArchivePath(inputPath);
+    QString inDir = QDir::fromNativeSeparators(inputPath);
+    while (inDir.endsWith("/"))
+        inDir.chop(1);
+    QString cultureId = inputTar ? archiveBaseName(inDir) : QFileInfo(inDir).fileName();
+
+    std::optional<Diagnostics::Scope> diagnosticsScope;
+    if (options.diagnostics)
+        diagnosticsScope.emplace(Diagnostics::Context{options.diagnostics, cultureId, {}});
+
+    if (!inputTar)
+    {
+        return outputTar ? convertToArchive(FileSystem::disk(), inDir, cultureId, outputPath, context, options)
+                         : convertToDirectory(FileSystem::disk(), inDir, outputPath, context, options);
+    }
+
+    Diagnostics::setStage("archive");
+    Diagnostics::info("progress", QString("Reading %1").arg(QDir::toNativeSeparators(inputPath)));
+    QFile file(inputPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        Diagnostics::error("archive-format", "Failed to open the archive: " + file.errorString(), QDir::toNativeSeparators(inputPath));
+        return ReturnValue::ERR_INPUT_ARCHIVE_INVALID;
+    }
+    // Map the archive if possible, as an uncompressed one is only parsed, never modified
+    QByteArray archive;
+    if (const auto mapped = file.map(0, file.size()))
+        archive = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), file.size());
+    else
+        archive = file.readAll();
+    TarArchive::Files files;
+    if (!TarArchive::read(archive, files))
+        return ReturnValue::ERR_INPUT_ARCHIVE_INVALID;
+    // Archives usually hold the sky culture directory itself, which then gives the culture ID
+    if (const auto root = TarArchive::stripRootDirectory(files); !root.isEmpty())
+        cultureId = root;
+
+    const MemoryFileSystem fs(cultureId, std::move(files));
+    return outputTar ? convertToArchive(fs, cultureId, cultureId, outputPath, context, options)
+                     : convertToDirectory(fs, cultureId, outputPath, context, options);
+}
+
+ReturnValue convertArchive(const QString &inputPath, const QString &outputPath, bool outputTar, const ConvertOptions &options)
+{
+    ConverterContext context;
+    return convertArchive(context, inputPath, outputPath, outputTar, options);
+}
+
+}
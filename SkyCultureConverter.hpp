@@ -19,8 +19,13 @@
 
 #pragma once
 
+#include <map>
 #include <QString>
+#include <QByteArray>
 #include <QtCore/qnamespace.h>
+#include "Diagnostics.hpp"
+#include "Progress.hpp"
+#include "ConverterContext.hpp"
 
 /// A single function interface to convert a sky culture directory into JSON and write to an output directory.
 namespace SkyCultureConverter
@@ -35,7 +40,10 @@ enum class ReturnValue
     ERR_OUTPUT_DIR_EXISTS,
     ERR_INFO_INI_NOT_FOUND,
     ERR_OUTPUT_DIR_CREATION_FAILED,
-    ERR_OUTPUT_FILE_WRITE_FAILED
+    ERR_OUTPUT_FILE_WRITE_FAILED,
+    ERR_CANCELLED,
+    ERR_INPUT_ARCHIVE_INVALID,
+    ERR_BOUNDARIES_NOT_FOUND
 };
 Q_ENUM_NS(ReturnValue)
 
@@ -49,6 +57,18 @@ Q_ENUM_NS(ReturnValue)
  * @param footnotesToRefs If true, converts footnotes to references.
  * @param genTranslatedMD If true, generates localized Markdown files.
  * @param convertUntranslatableNamesToNative If true, uses untranslatable names as native names.
+ * @param blobStoreDir Optional path to a content-addressed store of illustrations shared between
+ *                     conversions. Illustrations are then published from it by hardlinks or reflinks.
+ * @param maxTextureSize If positive, constellation art larger than this many pixels along either
+ *                       dimension is downscaled to fit, and its anchor points are scaled accordingly.
+ * @param imageCacheDir Optional path to a cache of downscaled illustrations, so that reconversions
+ *                      don't re-encode them.
+ * @param nativePoWriter If true, writes the .po files with the built-in serializer instead of libgettextpo.
+ * @param markdownCacheDir Optional path to a cache of the Markdown converted from the descriptions, so that
+ *                         reconversions skip the conversion of unchanged descriptions. The cache keeps the
+ *                         diagnostics of each conversion, and they are reported again on a hit.
+ * @param diagnostics Optional collector of the problems found during the conversion. If given, the
+ *                    messages are collected in it instead of being printed, unless its console sink is set.
  *
  * @return Return code indicating the result of the operation
  * @retval ReturnValue::CONVERT_SUCCESS                 - Conversion completed successfully
@@ -56,6 +76,8 @@ Q_ENUM_NS(ReturnValue)
  * @retval ReturnValue::ERR_INFO_INI_NOT_FOUND          - info.ini was not found in the input directory
  * @retval ReturnValue::ERR_OUTPUT_DIR_CREATION_FAILED  - Failed to create the output directory
  * @retval ReturnValue::ERR_OUTPUT_FILE_WRITE_FAILED    - Failed to write to an output file
+ * @retval ReturnValue::ERR_CANCELLED                   - The conversion was cancelled, see ConvertOptions
+ * @retval ReturnValue::ERR_INPUT_ARCHIVE_INVALID       - The input archive couldn't be read, see convertArchive()
  */
 ReturnValue convert(
     const QString &inputDir,
@@ -64,6 +86,125 @@ ReturnValue convert(
     const QString &nativeLocale = QString(),
     bool footnotesToRefs = false,
     bool genTranslatedMD = false,
-    bool convertUntranslatableNamesToNative = false);
+    bool convertUntranslatableNamesToNative = false,
+    const QString &blobStoreDir = QString(),
+    int maxTextureSize = 0,
+    const QString &imageCacheDir = QString(),
+    bool nativePoWriter = false,
+    const QString &markdownCacheDir = QString(),
+    Diagnostics::Collector *diagnostics = nullptr);
+
+/// Settings of a conversion. The fields shared with the parameters of convert() have the same meaning.
+struct ConvertOptions
+{
+    QString poDir;
+    QString nativeLocale;
+    bool footnotesToRefs = false;
+    bool genTranslatedMD = false;
+    bool convertUntranslatableNamesToNative = false;
+    QString blobStoreDir;
+    int maxTextureSize = 0;
+    QString imageCacheDir;
+    bool nativePoWriter = false;
+    QString markdownCacheDir;
+    /// Path on the disk to data/constellation_boundaries.dat of Stellarium, for the sky cultures using the
+    /// generic boundaries. By default it's looked up two levels above the input directory, as in a Stellarium
+    /// source tree. Sky cultures converted from memory or from archives have no such place, and fail with
+    /// ERR_BOUNDARIES_NOT_FOUND if they need the generic boundaries and this isn't set.
+    QString genericBoundariesFile;
+    Diagnostics::Collector *diagnostics = nullptr;
+    /// Called on the converting thread when the conversion enters a stage and moves between its items
+    ProgressCallback progress;
+    /// If set, the conversion stops soon after the token is cancelled and returns ERR_CANCELLED
+    const CancellationToken *cancellation = nullptr;
+};
+
+/**
+ * @brief Convert the sky culture from inputDir to outputDir, with the settings gathered in a struct.
+ *
+ * The output is built in a staging directory next to outputDir, which is renamed to outputDir only
+ * when the conversion succeeds. On failure or cancellation the staging directory is removed, so
+ * outputDir is either complete or absent.
+ *
+ * The return codes are as for the other overload.
+ */
+ReturnValue convert(const QString &inputDir, const QString &outputDir, const ConvertOptions &options);
+
+/**
+ * @brief Like the other overloads, but reusing the data cached in context by earlier conversions.
+ *
+ * A program converting many sky cultures should keep one context for all of them, so that the
+ * catalogs of stellarium-skycultures and the generic boundaries are parsed only once. The context
+ * may be shared by conversions running in parallel.
+ */
+ReturnValue convert(ConverterContext &context, const QString &inputDir, const QString &outputDir,
+                    const ConvertOptions &options);
+
+/// Contents of files keyed by their paths relative to the sky culture directory, e.g. "info.ini".
+using FileMap = std::map<QString, QByteArray>;
+
+/**
+ * @brief Convert a sky culture held in memory, without touching the disk except for poDir.
+ *
+ * @param cultureId ID of the sky culture, which is otherwise taken from the name of the input directory.
+ * @param inputFiles Files of the legacy sky culture, with the paths relative to its directory.
+ * @param outputFiles Receives the files of the converted sky culture, including the manifest,
+ *                    with the paths relative to the output directory. The .po files are
+ *                    always written with the built-in serializer.
+ *
+ * The rest of the parameters and the return codes are as for convert().
+ * ERR_OUTPUT_DIR_EXISTS and ERR_OUTPUT_DIR_CREATION_FAILED are never returned.
+ */
+ReturnValue convertInMemory(
+    const QString &cultureId,
+    const FileMap &inputFiles,
+    FileMap &outputFiles,
+    const QString &poDir = QString(),
+    const QString &nativeLocale = QString(),
+    bool footnotesToRefs = false,
+    bool genTranslatedMD = false,
+    bool convertUntranslatableNamesToNative = false,
+    int maxTextureSize = 0,
+    Diagnostics::Collector *diagnostics = nullptr);
+
+/// Like the other overload, but with the settings gathered in a struct. The fields that refer to caches and
+/// stores on the disk are ignored. On failure or cancellation outputFiles is left empty.
+ReturnValue convertInMemory(
+    const QString &cultureId,
+    const FileMap &inputFiles,
+    FileMap &outputFiles,
+    const ConvertOptions &options);
+
+/// Like the other overloads, but reusing the data cached in context by earlier conversions
+ReturnValue convertInMemory(
+    ConverterContext &context,
+    const QString &cultureId,
+    const FileMap &inputFiles,
+    FileMap &outputFiles,
+    const ConvertOptions &options);
+
+/**
+ * @brief Convert a sky culture where the input, the output, or both are tar archives.
+ *
+ * An inputPath ending with .tar, .tar.gz or .tgz is read as an archive, compressed with gzip or not, straight
+ * into memory. If all its files are in one top-level directory, the name of that directory is the culture ID,
+ * otherwise it's the name of the archive without the extensions. Other input paths are sky culture directories.
+ *
+ * If outputTar is true, the converted files are written into a new archive at outputPath, under a top-level
+ * directory named after the culture ID, and compressed with gzip if outputPath ends with .gz or .tgz. The files
+ * are held in memory until the conversion succeeds, so nothing is written but the archive, and the blob store
+ * doesn't apply. Otherwise the output is a directory, as with convert().
+ *
+ * The return codes are as for convert().
+ */
+ReturnValue convertArchive(
+    ConverterContext &context,
+    const QString &inputPath,
+    const QString &outputPath,
+    bool outputTar,
+    const ConvertOptions &options);
+
+/// Like the other overload, with a context used only for this conversion
+ReturnValue convertArchive(const QString &inputPath, const QString &outputPath, bool outputTar, const ConvertOptions &options);
 
 };
@@ -0,0 +1,422 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "TarArchive.hpp"
+
+#include <array>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <QDir>
+#include <zlib.h>
+#include "Diagnostics.hpp"
+
+namespace TarArchive
+{
+
+namespace
+{
+
+constexpr qsizetype blockSize = 512;
+
+// Offsets and sizes of the fields of a ustar header
+constexpr int nameOffset = 0, nameSize = 100;
+constexpr int modeOffset = 100, uidOffset = 108, gidOffset = 116, idSize = 8;
+constexpr int sizeOffset = 124, sizeSize = 12;
+constexpr int mtimeOffset = 136, mtimeSize = 12;
+constexpr int checksumOffset = 148, checksumSize = 8;
+constexpr int typeOffset = 156;
+constexpr int magicOffset = 257;
+// With its NUL, to tell it from the "ustar  " of old GNU headers, which have no prefix field
+constexpr char ustarMagic[] = "ustar";
+constexpr int prefixOffset = 345, prefixSize = 155;
+
+qsizetype paddedSize(const qsizetype size)
+{
+	return (size + blockSize - 1) / blockSize * blockSize;
+}
+
+// A NUL-terminated string field, which may also fill the whole field without a terminator
+QByteArray stringField(const char* data, const qsizetype size)
+{
+	return QByteArray(data, qstrnlen(data, size));
+}
+
+// Numeric fields are octal, padded with spaces or NULs, or base-256 if the high bit of the first byte is set
+bool numericField(const char* data, const int size, qint64& value)
+{
+	value = 0;
+	if(static_cast<unsigned char>(data[0]) & 0x80)
+	{
+		value = static_cast<unsigned char>(data[0]) & 0x3f;
+		for(int n = 1; n < size; ++n)
+		{
+			if(value > (std::numeric_limits<qint64>::max() >> 8))
+				return false;
+			value = (value << 8) | static_cast<unsigned char>(data[n]);
+		}
+		return true;
+	}
+	int n = 0;
+	while(n < size && data[n] == ' ')
+		++n;
+	for(; n < size && data[n] >= '0' && data[n] <= '7'; ++n)
+	{
+		if(value > (std::numeric_limits<qint64>::max() >> 3))
+			return false;
+		value = value * 8 + (data[n] - '0');
+	}
+	return n == size || data[n] == ' ' || data[n] == '\0';
+}
+
+bool checksumMatches(const char* header)
+{
+	qint64 stored = 0;
+	if(!numericField(header + checksumOffset, checksumSize, stored))
+		return false;
+	// The checksum is computed with its own field filled with spaces. Some old tars summed signed chars.
+	qint64 unsignedSum = 0, signedSum = 0;
+	for(int n = 0; n < blockSize; ++n)
+	{
+		const bool inChecksum = n >= checksumOffset && n < checksumOffset + checksumSize;
+		unsignedSum += inChecksum ? ' ' : static_cast<unsigned char>(header[n]);
+		signedSum += inChecksum ? ' ' : static_cast<signed char>(header[n]);
+	}
+	return stored == unsignedSum || stored == signedSum;
+}
+
+bool isZeroBlock(const char* block)
+{
+	return std::all_of(block, block + blockSize, [](const char c) { return c == 0; });
+}
+
+// Extracts the path from the records of a pax extended header, each of the form "<length> <key>=<value>\n"
+QByteArray paxPath(const QByteArray& records)
+{
+	QByteArray path;
+	for(qsizetype pos = 0; pos < records.size(); )
+	{
+		const auto space = records.indexOf(' ', pos);
+		if(space < 0) break;
+		bool ok = false;
+		const auto length = records.mid(pos, space - pos).toLongLong(&ok);
+		if(!ok || length <= space - pos || pos + length > records.size()) break;
+		const auto record = records.mid(space + 1, pos + length - space - 2); // without the newline
+		if(record.startsWith("path="))
+			path = record.mid(5);
+		pos += length;
+	}
+	return path;
+}
+
+// Makes the path relative and clean, or returns an empty string if it points outside of the archive
+QString normalizedPath(const QByteArray& rawPath)
+{
+	const auto path = QDir::cleanPath(QString::fromUtf8(rawPath));
+	if(path.isEmpty() || path == "." || path.startsWith('/') || path == ".." || path.startsWith("../"))
+		return {};
+	return path.startsWith("./") ? path.mid(2) : path;
+}
+
+bool gunzip(const QByteArray& compressed, QByteArray& out)
+{
+	z_stream stream = {};
+	// 32 makes zlib detect the gzip header
+	if(inflateInit2(&stream, 15 + 32) != Z_OK)
+		return false;
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.constData()));
+	stream.avail_in = static_cast<uInt>(compressed.size());
+
+	std::array<char, 256*1024> chunk;
+	int rc = Z_OK;
+	for(;;)
+	{
+		stream.next_out = reinterpret_cast<Bytef*>(chunk.data());
+		stream.avail_out = chunk.size();
+		rc = inflate(&stream, Z_NO_FLUSH);
+		// A truncated stream ends with Z_BUF_ERROR, when no progress is possible
+		if(rc != Z_OK && rc != Z_STREAM_END)
+			break;
+		out.append(chunk.data(), chunk.size() - stream.avail_out);
+		if(rc != Z_STREAM_END)
+			continue;
+		if(stream.avail_in == 0)
+			break;
+		// Concatenated gzip members form a valid gzip file too
+		if(inflateReset(&stream) != Z_OK)
+		{
+			rc = Z_DATA_ERROR;
+			break;
+		}
+	}
+	inflateEnd(&stream);
+	return rc == Z_STREAM_END;
+}
+
+bool formatNumericField(char* field, const int size, const qint64 value)
+{
+	// size-1 octal digits and a terminating NUL
+	if(value < 0 || value >= (qint64(1) << (3 * (size - 1))))
+		return false;
+	std::snprintf(field, size, "%0*llo", size - 1, static_cast<unsigned long long>(value));
+	return true;
+}
+
+// Splits the UTF-8 path into the name and prefix fields of a ustar header
+bool splitPath(const QByteArray& path, QByteArray& name, QByteArray& prefix)
+{
+	if(path.size() <= nameSize)
+	{
+		name = path;
+		prefix.clear();
+		return true;
+	}
+	for(auto slash = path.lastIndexOf('/'); slash > 0; slash = path.lastIndexOf('/', slash - 1))
+	{
+		if(path.size() - slash - 1 > nameSize)
+			return false;
+		if(slash <= prefixSize)
+		{
+			prefix = path.left(slash);
+			name = path.mid(slash + 1);
+			return !name.isEmpty();
+		}
+	}
+	return false;
+}
+
+}
+
+bool isArchivePath(const QString& path)
+{
+	return path.endsWith(".tar", Qt::CaseInsensitive) || path.endsWith(".tar.gz", Qt::CaseInsensitive) ||
+	       path.endsWith(".tgz", Qt::CaseInsensitive);
+}
+
+bool isCompressedPath(const QString& path)
+{
+	return path.endsWith(".gz", Qt::CaseInsensitive) || path.endsWith(".tgz", Qt::CaseInsensitive);
+}
+
+bool read(const QByteArray& archive, Files& files)
+{
+	QByteArray uncompressed;
+	const bool compressed = archive.size() >= 2 && archive[0] == '\x1f' && archive[1] == '\x8b';
+	if(compressed && !gunzip(archive, uncompressed))
+	{
+		Diagnostics::error("archive-format", "Failed to decompress the archive");
+		return false;
+	}
+	const QByteArray& data = compressed ? uncompressed : archive;
+
+	QByteArray longPath; // from a GNU long name entry or a pax header, applies to the next entry
+	for(qsizetype pos = 0; pos + blockSize <= data.size(); )
+	{
+		const char* header = data.constData() + pos;
+		if(isZeroBlock(header))
+			return true;
+		if(!checksumMatches(header))
+		{
+			Diagnostics::error("archive-format", QString("Bad checksum of the tar header at offset %1").arg(pos));
+			return false;
+		}
+		qint64 size = 0;
+		if(!numericField(header + sizeOffset, sizeSize, size) || size < 0)
+		{
+			Diagnostics::error("archive-format", QString("Bad size in the tar header at offset %1").arg(pos));
+			return false;
+		}
+		const qsizetype dataPos = pos + blockSize;
+		if(size > data.size() - dataPos)
+		{
+			Diagnostics::error("archive-format", "The archive is truncated");
+			return false;
+		}
+		const auto contents = QByteArray::fromRawData(data.constData() + dataPos, size);
+		pos = dataPos + paddedSize(size);
+
+		QByteArray path = longPath;
+		longPath.clear();
+		if(path.isEmpty())
+		{
+			path = stringField(header + nameOffset, nameSize);
+			if(std::memcmp(header + magicOffset, ustarMagic, sizeof ustarMagic) == 0)
+			{
+				const auto prefix = stringField(header + prefixOffset, prefixSize);
+				if(!prefix.isEmpty())
+					path = prefix + '/' + path;
+			}
+		}
+
+		switch(header[typeOffset])
+		{
+		case 'L': // GNU long name
+			longPath = stringField(contents.constData(), contents.size());
+			break;
+		case 'x': // pax extended header
+			longPath = paxPath(contents);
+			break;
+		case '0':
+		case '\0':
+		case '7': // contiguous file
+		{
+			const auto name = normalizedPath(path);
+			if(name.isEmpty())
+			{
+				Diagnostics::warning("archive-format", "Skipping an entry with a path outside of the archive: " +
+				                     QString::fromUtf8(path));
+				break;
+			}
+			files[name] = QByteArray(contents.constData(), contents.size());
+			break;
+		}
+		default: // directories, links, global pax headers etc.
+			break;
+		}
+	}
+	// Some writers omit the end-of-archive marker
+	return true;
+}
+
+QString stripRootDirectory(Files& files)
+{
+	if(files.empty())
+		return {};
+	const auto& first = files.begin()->first;
+	const auto slash = first.indexOf('/');
+	if(slash <= 0)
+		return {};
+	const auto root = first.left(slash + 1);
+	for(const auto& [path, contents] : files)
+	{
+		if(!path.startsWith(root))
+			return {};
+	}
+	Files stripped;
+	for(auto& [path, contents] : files)
+		stripped.emplace(path.mid(root.size()), std::move(contents));
+	files = std::move(stripped);
+	return root.chopped(1);
+}
+
+struct Writer::Deflater
+{
+	z_stream stream = {};
+	std::array<char, 64*1024> buffer;
+	bool initialized = false;
+
+	Deflater()
+	{
+		// 16 makes zlib write a gzip header and trailer
+		initialized = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+	}
+	~Deflater()
+	{
+		if(initialized)
+			deflateEnd(&stream);
+	}
+
+	bool feed(const char* data, const qint64 size, const int flush, QIODevice& device)
+	{
+		if(!initialized)
+			return false;
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+		stream.avail_in = static_cast<uInt>(size);
+		for(;;)
+		{
+			stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+			stream.avail_out = buffer.size();
+			const int rc = deflate(&stream, flush);
+			if(rc == Z_STREAM_ERROR)
+				return false;
+			const qint64 produced = buffer.size() - stream.avail_out;
+			if(produced && device.write(buffer.data(), produced) != produced)
+				return false;
+			if(flush == Z_FINISH ? rc == Z_STREAM_END : stream.avail_out != 0)
+				return true;
+		}
+	}
+};
+
+Writer::Writer(QIODevice& device, const bool gzip)
+	: device(device)
+	, deflater(gzip ? std::make_unique<Deflater>() : nullptr)
+{
+}
+
+Writer::~Writer() = default;
+
+bool Writer::write(const char* data, const qint64 size)
+{
+	if(!ok)
+		return false;
+	ok = deflater ? deflater->feed(data, size, Z_NO_FLUSH, device)
+	              : device.write(data, size) == size;
+	return ok;
+}
+
+bool Writer::addFile(const QString& path, const QByteArray& data)
+{
+	QByteArray name, prefix;
+	if(!splitPath(path.toUtf8(), name, prefix))
+	{
+		Diagnostics::error("archive-format", "The path is too long for a tar archive: " + path);
+		return ok = false;
+	}
+
+	std::array<char, blockSize> header = {};
+	std::memcpy(header.data() + nameOffset, name.constData(), name.size());
+	std::memcpy(header.data() + prefixOffset, prefix.constData(), prefix.size());
+	formatNumericField(header.data() + modeOffset, idSize, 0644);
+	formatNumericField(header.data() + uidOffset, idSize, 0);
+	formatNumericField(header.data() + gidOffset, idSize, 0);
+	if(!formatNumericField(header.data() + sizeOffset, sizeSize, data.size()))
+	{
+		Diagnostics::error("archive-format", "The file is too large for a tar archive: " + path);
+		return ok = false;
+	}
+	formatNumericField(header.data() + mtimeOffset, mtimeSize, 0);
+	header[typeOffset] = '0';
+	std::memcpy(header.data() + magicOffset, "ustar\0" "00", 8);
+
+	std::memset(header.data() + checksumOffset, ' ', checksumSize);
+	unsigned checksum = 0;
+	for(const char c : header)
+		checksum += static_cast<unsigned char>(c);
+	std::snprintf(header.data() + checksumOffset, checksumSize, "%06o", checksum); // followed by NUL and a space
+	header[checksumOffset + checksumSize - 1] = ' ';
+
+	static const std::array<char, blockSize> zeros = {};
+	return write(header.data(), header.size()) &&
+	       write(data.constData(), data.size()) &&
+	       write(zeros.data(), paddedSize(data.size()) - data.size());
+}
+
+bool Writer::finish()
+{
+	static const std::array<char, 2 * blockSize> endMarker = {};
+	if(!write(endMarker.data(), endMarker.size()))
+		return false;
+	if(deflater)
+		ok = deflater->feed(nullptr, 0, Z_FINISH, device);
+	return ok;
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <QString>
+#include <QIODevice>
+#include <QByteArray>
+
+//! Reading and writing of the tar archives in which sky cultures are exchanged. Only regular
+//! files are of interest: directories, links and the like are skipped when reading and never
+//! written. Archives compressed with gzip are recognized by their contents when reading.
+namespace TarArchive
+{
+
+using Files = std::map<QString/*path*/, QByteArray/*contents*/>;
+
+//! Whether the path names a tar archive rather than a directory, judging by its extension
+//! (.tar, .tar.gz or .tgz)
+bool isArchivePath(const QString& path);
+//! Whether an archive at the path should be compressed, i.e. whether it ends with .gz or .tgz
+bool isCompressedPath(const QString& path);
+
+//! Extracts the regular files of the archive, which may be compressed with gzip, into files.
+//! Understands the ustar, GNU and pax ways of storing long names. Returns false on a malformed
+//! archive, with the problem reported to Diagnostics.
+bool read(const QByteArray& archive, Files& files);
+
+//! If all the files are in one top-level directory, removes it from their paths and returns its
+//! name. Otherwise leaves the files alone and returns an empty string.
+QString stripRootDirectory(Files& files);
+
+//! Writes ustar archives entry by entry to a device, optionally compressing them on the fly with
+//! gzip. The entries have the modification time of the epoch and no owner, so that converting
+//! the same input produces the same archive.
+class Writer
+{
+public:
+	Writer(QIODevice& device, bool gzip);
+	~Writer();
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+
+	//! Appends a regular file. Fails if the path doesn't fit in a ustar header.
+	bool addFile(const QString& path, const QByteArray& data);
+	//! Writes the end-of-archive marker and flushes the compressor. No files may be added after that.
+	bool finish();
+
+private:
+	bool write(const char* data, qint64 size);
+
+	struct Deflater;
+	QIODevice& device;
+	std::unique_ptr<Deflater> deflater;
+	bool ok = true;
+};
+
+}
@@ -0,0 +1,89 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "TaskQueue.hpp"
+
+#include <algorithm>
+
+TaskQueue::TaskQueue(const unsigned workerCount, const std::size_t capacity)
+	: workerCount(std::max(1u, workerCount))
+	, capacity(std::max<std::size_t>(1, capacity))
+{
+}
+
+TaskQueue::~TaskQueue()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+	for(auto& worker : workers)
+		worker.join();
+}
+
+void TaskQueue::push(std::function<bool()> task)
+{
+	{
+		std::unique_lock lock(mutex);
+		// Workers are only started when there's some work to do
+		if(workers.empty())
+		{
+			for(unsigned n = 0; n < workerCount; ++n)
+				workers.emplace_back([this]{ run(); });
+		}
+		spaceAvailable.wait(lock, [this]{ return tasks.size() < capacity; });
+		tasks.push_back(std::move(task));
+	}
+	taskAvailable.notify_one();
+}
+
+bool TaskQueue::wait()
+{
+	std::unique_lock lock(mutex);
+	allDone.wait(lock, [this]{ return tasks.empty() && activeTasks == 0; });
+	const bool ok = !anyFailed;
+	anyFailed = false;
+	return ok;
+}
+
+void TaskQueue::run()
+{
+	std::unique_lock lock(mutex);
+	for(;;)
+	{
+		// Finish the remaining tasks even when stopping, so that nothing is silently dropped
+		taskAvailable.wait(lock, [this]{ return stopping || !tasks.empty(); });
+		if(tasks.empty()) return;
+
+		auto task = std::move(tasks.front());
+		tasks.pop_front();
+		++activeTasks;
+		lock.unlock();
+		spaceAvailable.notify_one();
+
+		const bool ok = task();
+
+		lock.lock();
+		--activeTasks;
+		if(!ok) anyFailed = true;
+		if(tasks.empty() && activeTasks == 0)
+			allDone.notify_all();
+	}
+}
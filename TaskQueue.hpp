@@ -0,0 +1,58 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+//! A bounded queue of tasks executed by a pool of background threads. Each task returns
+//! whether it succeeded, and wait() reports whether all the tasks since the previous wait() did.
+class TaskQueue
+{
+public:
+	TaskQueue(unsigned workerCount, std::size_t capacity);
+	~TaskQueue();
+	TaskQueue(const TaskQueue&) = delete;
+	TaskQueue& operator=(const TaskQueue&) = delete;
+
+	//! Enqueues the task, blocking while the queue is full
+	void push(std::function<bool()> task);
+	//! Waits until all the enqueued tasks have finished. Returns false if any of them failed.
+	bool wait();
+
+private:
+	void run();
+
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable spaceAvailable;
+	std::condition_variable allDone;
+	std::deque<std::function<bool()>> tasks;
+	std::vector<std::thread> workers;
+	const unsigned workerCount;
+	const std::size_t capacity;
+	unsigned activeTasks = 0;
+	bool anyFailed = false;
+	bool stopping = false;
+};
@@ -19,9 +19,10 @@
 
 #include "Utils.hpp"
 #include <iomanip>
-#include <iostream>
+#include <ostream>
 #include <QDebug>
 #include <QStringList>
+#include "Diagnostics.hpp"
 
 std::vector<int> parseReferences(const QString& inStr)
 {
@@ -53,8 +54,7 @@ QString formatReferences(const std::vector<int>& refs)
 
 void warnAboutSpecialChars(const QString& s, const QString& what)
 {
-    std::cerr << "WARNING: special character " << what.toStdString()
-              << " found in string \"" << s.toStdString() << "\"\n";
+	Diagnostics::warning("special-character", QString("special character %1 found in string \"%2\"").arg(what, s));
 }
 
 QString jsonEscape(const QString& string, const bool warn)
@@ -90,3 +90,203 @@ QString jsonEscape(const QString& string, const bool warn)
 	}
 	return out;
 }
+
+namespace
+{
+
+// Accumulates UTF-8 output in a small fixed buffer to avoid per-byte stream calls
+class Utf8Writer
+{
+public:
+	explicit Utf8Writer(std::ostream& s) : s(s) {}
+	~Utf8Writer() { flush(); }
+
+	void put(const char c)
+	{
+		if(size == sizeof buffer) flush();
+		buffer[size++] = c;
+	}
+	void put(const char* str)
+	{
+		while(*str) put(*str++);
+	}
+	void putCodePoint(const char32_t u)
+	{
+		if(u < 0x80)
+		{
+			put(char(u));
+		}
+		else if(u < 0x800)
+		{
+			put(char(0xC0 | (u >> 6)));
+			put(char(0x80 | (u & 0x3F)));
+		}
+		else if(u < 0x10000)
+		{
+			put(char(0xE0 | (u >> 12)));
+			put(char(0x80 | ((u >> 6) & 0x3F)));
+			put(char(0x80 | (u & 0x3F)));
+		}
+		else
+		{
+			put(char(0xF0 | (u >> 18)));
+			put(char(0x80 | ((u >> 12) & 0x3F)));
+			put(char(0x80 | ((u >> 6) & 0x3F)));
+			put(char(0x80 | (u & 0x3F)));
+		}
+	}
+	void flush()
+	{
+		s.write(buffer, size);
+		size = 0;
+	}
+
+private:
+	std::ostream& s;
+	char buffer[256];
+	std::streamsize size = 0;
+};
+
+// Returns the code point starting at string[pos] and advances pos past it
+char32_t nextCodePoint(const QStringView string, qsizetype& pos)
+{
+	const char16_t c = string[pos++].unicode();
+	if(!QChar::isSurrogate(c))
+		return c;
+	if(QChar::isHighSurrogate(c) && pos < string.size() && string[pos].isLowSurrogate())
+		return QChar::surrogateToUcs4(c, string[pos++].unicode());
+	return QChar::ReplacementCharacter; // same as what QString::toUtf8() does
+}
+
+}
+
+qsizetype utf8Length(const QStringView string)
+{
+	qsizetype length = 0;
+	for(qsizetype pos = 0; pos < string.size(); )
+	{
+		const auto u = nextCodePoint(string, pos);
+		length += u < 0x80 ? 1 : u < 0x800 ? 2 : u < 0x10000 ? 3 : 4;
+	}
+	return length;
+}
+
+void writeUtf8(std::ostream& s, const QStringView string)
+{
+	Utf8Writer out(s);
+	for(qsizetype pos = 0; pos < string.size(); )
+		out.putCodePoint(nextCodePoint(string, pos));
+}
+
+void writeJSONEscaped(std::ostream& s, const QStringView string, const bool warn)
+{
+	static constexpr char hexDigits[] = "0123456789abcdef";
+	Utf8Writer out(s);
+	for(qsizetype pos = 0; pos < string.size(); )
+	{
+		const auto u = nextCodePoint(string, pos);
+		if(u == '\\')
+		{
+			out.put("\\\\");
+			if(warn) warnAboutSpecialChars(string.toString(), "\"backslash\"");
+		}
+		else if(u == '\n')
+		{
+			out.put("\\n");
+			if(warn) warnAboutSpecialChars(string.toString(), "\"line break\"");
+		}
+		else if(u == '"')
+		{
+			out.put("\\\"");
+			if(warn) warnAboutSpecialChars(string.toString(), "\"quotation mark\"");
+		}
+		else if(u < 0x20)
+		{
+			out.put("\\u00");
+			out.put(hexDigits[u >> 4]);
+			out.put(hexDigits[u & 0xF]);
+			if(warn) warnAboutSpecialChars(string.toString(), QString("0x%1").arg(unsigned(u), 4, 16, QLatin1Char('0')));
+		}
+		else
+		{
+			out.putCodePoint(u);
+		}
+	}
+}
+
+void writeReferences(std::ostream& s, const std::vector<int>& refs)
+{
+	for(unsigned n = 0; n < refs.size(); ++n)
+	{
+		if(n) s << ',';
+		s << refs[n];
+	}
+}
+
+QHash<QString, QString> parseIni(const QByteArray& data)
+{
+	QHash<QString, QString> values;
+	QString section;
+	// QSettings skips a UTF-8 byte order mark, which would otherwise become a part of the first line
+	const QByteArrayView bom = "\xEF\xBB\xBF";
+	const auto text = QString::fromUtf8(data.startsWith(bom) ? QByteArrayView(data).sliced(bom.size()) : QByteArrayView(data));
+	for(const auto& rawLine : text.split('\n'))
+	{
+		const auto line = rawLine.trimmed();
+		if(line.isEmpty() || line.startsWith(';') || line.startsWith('#'))
+			continue;
+		if(line.startsWith('['))
+		{
+			const auto end = line.indexOf(']');
+			section = line.mid(1, end < 0 ? -1 : end - 1).trimmed();
+			if(section.compare("General", Qt::CaseInsensitive) == 0)
+				section.clear();
+			continue;
+		}
+		const auto eq = line.indexOf('=');
+		if(eq < 0)
+			continue;
+
+		// Unquoted whitespace is only kept between other characters
+		QStringList items{QString()};
+		QString pendingSpace;
+		bool inQuotes = false;
+		for(qsizetype i = eq + 1; i < line.size(); ++i)
+		{
+			QChar c = line[i];
+			if(c == '"')
+			{
+				inQuotes = !inQuotes;
+				continue;
+			}
+			if(!inQuotes && c == ';')
+				break;
+			if(!inQuotes && c == ',')
+			{
+				items.append(QString());
+				pendingSpace.clear();
+				continue;
+			}
+			if(!inQuotes && c.isSpace())
+			{
+				if(!items.back().isEmpty())
+					pendingSpace += c;
+				continue;
+			}
+			if(c == '\\' && i + 1 < line.size())
+			{
+				c = line[++i];
+				if(c == 'n') c = '\n';
+				else if(c == 't') c = '\t';
+				else if(c == 'r') c = '\r';
+			}
+			items.back() += pendingSpace;
+			pendingSpace.clear();
+			items.back() += c;
+		}
+
+		const auto key = line.left(eq).trimmed();
+		values[section.isEmpty() ? key : section + "/" + key] = items.size() == 1 ? items[0] : QString();
+	}
+	return values;
+}
@@ -20,10 +20,24 @@
 #pragma once
 
 #include <vector>
+#include <iosfwd>
+#include <QHash>
 #include <QString>
+#include <QStringView>
 
 inline const QString translatorsCommentPrefix = "TRANSLATORS:";
 std::vector<int> parseReferences(const QString& inStr);
 QString formatReferences(const std::vector<int>& refs);
 QString jsonEscape(const QString& string, bool warnAboutSpecialChars = false);
 inline QString jsonEscapeAndWarn(const QString& string) { return jsonEscape(string, true); }
+
+// Streaming counterparts of the above: these write UTF-8 directly to the stream without temporary strings
+qsizetype utf8Length(QStringView string);
+void writeUtf8(std::ostream& s, QStringView string);
+void writeJSONEscaped(std::ostream& s, QStringView string, bool warnAboutSpecialChars = false);
+void writeReferences(std::ostream& s, const std::vector<int>& refs);
+
+// Reads the values of an INI file held in memory the way QSettings::IniFormat reads them from a file,
+// keyed by "section/key". Values that QSettings would split into several strings at unquoted commas
+// are left empty, as QVariant::toString() of such a list is.
+QHash<QString, QString> parseIni(const QByteArray& data);
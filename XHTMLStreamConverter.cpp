@@ -0,0 +1,542 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "XHTMLStreamConverter.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <QDebug>
+#include <QXmlStreamReader>
+#include <QRegularExpression>
+#include "Regex.hpp"
+#include "Diagnostics.hpp"
+
+namespace
+{
+
+class Converter
+{
+public:
+	explicit Converter(const bool footnotesToRefs)
+		: footnotesToRefs(footnotesToRefs)
+	{
+	}
+
+	// Returns false if the document needs the DOM-based converter
+	bool run(const QByteArray& xhtml);
+	void emitWarnings() const;
+	QString takeMarkdown() { return std::move(markdown); }
+
+private:
+	enum class FrameType
+	{
+		Body,
+		Paragraph,
+		Heading,
+		Emphasis,
+		Footnote,
+		Link,
+		Blockquote,
+		Table,
+		TableRow,
+		TableCell,
+		List,
+		ListItem,
+		Sup,
+	};
+	struct Frame
+	{
+		FrameType type;
+		// Position in the output where the content of the element starts
+		qsizetype start;
+		// Position in the output where the string the DOM-based converter would write the content into starts.
+		// Elements that are post-processed as a whole are converted into a separate string there.
+		qsizetype bufferStart;
+		bool insideTable;
+		bool footnotesToRefs;
+		QString prefix; // heading marker, emphasis marking, footnote number or link target
+		bool flag = false; // emits h1 for headings, is header for table rows, is first row for tables, is ordered for lists
+		std::vector<QString> items; // table row columns or list items
+	};
+
+	QXmlStreamReader reader;
+	QString markdown;
+	std::vector<Frame> frames;
+	std::vector<std::function<void()>> warnings;
+	const bool footnotesToRefs;
+	bool h1emitted = false;
+
+	bool findBody();
+	bool startElement();
+	bool endElement();
+	bool isStructural() const;
+	void pushFrame(FrameType type, bool separateBuffer);
+	void addNewlineBeforeNodeIfNeeded();
+	void formatImg(const QXmlStreamAttributes& attrs);
+	QString takeContent(const Frame& frame);
+	void emitTableRow(const Frame& row, Frame& table);
+};
+
+bool Converter::findBody()
+{
+	while(reader.readNextStartElement())
+	{
+		if(reader.qualifiedName() == u"html")
+		{
+			while(reader.readNextStartElement())
+			{
+				if(reader.qualifiedName() == u"body")
+					return true;
+				reader.skipCurrentElement();
+			}
+			return false;
+		}
+		reader.skipCurrentElement();
+	}
+	return false;
+}
+
+bool Converter::isStructural() const
+{
+	// These elements can only contain particular child elements in Markdown
+	const auto type = frames.back().type;
+	return type == FrameType::Table || type == FrameType::TableRow || type == FrameType::List || type == FrameType::Sup;
+}
+
+void Converter::pushFrame(const FrameType type, const bool separateBuffer)
+{
+	const auto& parent = frames.back();
+	frames.push_back({type, markdown.size(), separateBuffer ? markdown.size() : parent.bufferStart,
+	                  parent.insideTable, parent.footnotesToRefs, {}, false, {}});
+}
+
+void Converter::addNewlineBeforeNodeIfNeeded()
+{
+	if(markdown.size() > frames.back().bufferStart && !markdown.back().isSpace())
+		markdown += '\n';
+}
+
+void Converter::formatImg(const QXmlStreamAttributes& attrs)
+{
+	markdown += "<img";
+	if(attrs.hasAttribute("width"))
+		markdown += " width=\"" + attrs.value("width").toString() + "\"";
+	if(attrs.hasAttribute("height"))
+		markdown += " height=\"" + attrs.value("height").toString() + "\"";
+	if(attrs.hasAttribute("src"))
+		markdown += " src=\"" + attrs.value("src").toString() + "\"";
+	if(attrs.hasAttribute("alt"))
+		markdown += " alt=\"" + attrs.value("alt").toString() + "\"";
+	markdown += "/>";
+}
+
+QString Converter::takeContent(const Frame& frame)
+{
+	auto content = markdown.mid(frame.start);
+	markdown.truncate(frame.start);
+	return content;
+}
+
+bool Converter::startElement()
+{
+	const auto tagName = reader.qualifiedName().toString();
+	const auto tag = tagName.toLower();
+	const auto attrs = reader.attributes();
+	auto& parent = frames.back();
+
+	switch(parent.type)
+	{
+	case FrameType::Table:
+		if(tag != "tr" || attrs.hasAttribute("colspan") || attrs.hasAttribute("rowspan"))
+			return false;
+		pushFrame(FrameType::TableRow, false);
+		return true;
+	case FrameType::TableRow:
+		if((tag != "td" && tag != "th") || attrs.hasAttribute("colspan") || attrs.hasAttribute("rowspan"))
+			return false;
+		if(tag == "th")
+			parent.flag = true;
+		pushFrame(FrameType::TableCell, true);
+		frames.back().insideTable = true;
+		frames.back().footnotesToRefs = false;
+		return true;
+	case FrameType::List:
+		if(tag != "li")
+			return false;
+		pushFrame(FrameType::ListItem, true);
+		frames.back().insideTable = true;
+		frames.back().footnotesToRefs = false;
+		return true;
+	case FrameType::Sup:
+	{
+		// Only a footnote reference can be converted, the rest is serialized as HTML
+		if(!parent.footnotesToRefs || tagName != "a")
+			return false;
+		const auto match = Regex::get(Regex::FootnoteHref).match(attrs.value("href").toString());
+		markdown += "[#";
+		markdown += match.captured(1);
+		markdown += "]";
+		reader.skipCurrentElement(); // the <a>
+		reader.skipCurrentElement(); // the rest of <sup>
+		frames.pop_back();
+		return true;
+	}
+	default:
+		break;
+	}
+
+	if(tag.size() == 2 && tag[0] == QLatin1Char('h') && '1' <= tag[1] && tag[1] <= '6')
+	{
+		if(parent.insideTable)
+			return false;
+
+		const int level = tag[1].toLatin1() - '0';
+		QString prefix;
+		bool emitsH1 = false;
+		if(level == 1)
+		{
+			if(h1emitted)
+			{
+				warnings.emplace_back([]{ Diagnostics::warning("html-structure", "Unexpected repeated <h1> tag. Demoting it to <h3>."); });
+				prefix = "\n### ";
+			}
+			else
+			{
+				prefix = "\n# ";
+				emitsH1 = true;
+			}
+		}
+		else
+		{
+			if(!h1emitted)
+			{
+				warnings.emplace_back([tag]{ Diagnostics::error("html-structure", "Unexpected <" + tag +
+				                                                "> tag before any <h1> tag was found"); });
+			}
+			prefix = '\n' + QString(level, QLatin1Char('#')) + ' ';
+		}
+		pushFrame(FrameType::Heading, true);
+		frames.back().prefix = prefix;
+		frames.back().flag = emitsH1;
+	}
+	else if(tag == "i" || tag == "em" || tag == "b")
+	{
+		pushFrame(FrameType::Emphasis, true);
+		frames.back().prefix = tag == "b" ? "**" : "*";
+	}
+	else if(tag == "p")
+	{
+		if(attrs.hasAttribute("id"))
+		{
+			if(!parent.footnotesToRefs)
+				return false;
+			const auto number = Regex::get(Regex::FootnoteId).match(attrs.value("id").toString()).captured(1);
+			addNewlineBeforeNodeIfNeeded();
+			markdown += " - [#";
+			markdown += number;
+			markdown += "]: ";
+			pushFrame(FrameType::Footnote, true);
+			frames.back().prefix = number;
+		}
+		else
+		{
+			markdown += "\n";
+			pushFrame(FrameType::Paragraph, false);
+		}
+	}
+	else if(tag == "img")
+	{
+		if(attrs.hasAttribute("width") || attrs.hasAttribute("height"))
+		{
+			formatImg(attrs);
+		}
+		else
+		{
+			markdown += "![";
+			markdown += attrs.value("alt");
+			markdown += "](";
+			markdown += attrs.value("src");
+			markdown += ")";
+		}
+		reader.skipCurrentElement();
+	}
+	else if(tag == "a")
+	{
+		pushFrame(FrameType::Link, true);
+		frames.back().prefix = attrs.value("href").toString();
+	}
+	else if(tag == "br")
+	{
+		if(parent.insideTable)
+			markdown += "<br>";
+		else
+			markdown += "\n\n";
+		reader.skipCurrentElement();
+	}
+	else if(tag == "table")
+	{
+		// Layout tables are kept in HTML
+		if(attrs.value("class") == u"layout")
+			return false;
+		pushFrame(FrameType::Table, false);
+		frames.back().flag = true;
+	}
+	else if(tag == "ul" || tag == "ol")
+	{
+		pushFrame(FrameType::List, false);
+		frames.back().flag = tagName == "ol";
+	}
+	else if(tag == "blockquote")
+	{
+		pushFrame(FrameType::Blockquote, true);
+	}
+	else if(tag == "sup")
+	{
+		pushFrame(FrameType::Sup, false);
+	}
+	else if(tag == "sub" || tag == "dl")
+	{
+		// Kept in HTML
+		return false;
+	}
+	else
+	{
+		warnings.emplace_back([tagName]{ Diagnostics::warning("unhandled-element", "Unhandled HTML element: " + tagName); });
+		reader.skipCurrentElement();
+	}
+	return true;
+}
+
+void Converter::emitTableRow(const Frame& row, Frame& table)
+{
+	const auto& columns = row.items;
+	const bool firstRow = table.flag;
+	const bool isHeader = row.flag;
+	const auto addSeparatorLine = [this, &columns](const QLatin1Char fill)
+	{
+		markdown += "|";
+		for(const auto& column : columns)
+		{
+			markdown += QString(column.size() + 2, fill);
+			markdown += "|";
+		}
+		markdown += "\n";
+	};
+
+	if(firstRow && !isHeader)
+	{
+		// Create an empty header
+		addSeparatorLine(QLatin1Char(' '));
+		addSeparatorLine(QLatin1Char('-'));
+	}
+
+	markdown += "|";
+	for(const auto& column : columns)
+	{
+		markdown += " ";
+		markdown += column;
+		markdown += " |";
+	}
+	markdown += "\n";
+
+	if(firstRow && isHeader)
+		addSeparatorLine(QLatin1Char('-'));
+
+	table.flag = false;
+}
+
+bool Converter::endElement()
+{
+	auto frame = std::move(frames.back());
+	frames.pop_back();
+
+	switch(frame.type)
+	{
+	case FrameType::Body:
+		break;
+	case FrameType::Paragraph:
+		markdown += "\n";
+		break;
+	case FrameType::Heading:
+	{
+		const auto text = takeContent(frame).simplified();
+		markdown += frame.prefix;
+		markdown += text;
+		markdown += '\n';
+		if(frame.flag)
+			h1emitted = true;
+		break;
+	}
+	case FrameType::Emphasis:
+	{
+		auto text = takeContent(frame);
+		const auto& marking = frame.prefix;
+		markdown += marking;
+		qsizetype begin = 0;
+		while(begin < text.size() && text[begin].isSpace())
+			markdown += text[begin++];
+		auto end = text.size();
+		while(end > begin && text[end - 1].isSpace())
+			--end;
+		markdown += QStringView(text).mid(begin, end - begin);
+		markdown += marking;
+		markdown += QStringView(text).mid(end);
+		break;
+	}
+	case FrameType::Footnote:
+	{
+		auto text = takeContent(frame).simplified();
+		const QRegularExpression textToRemove("^\\[\\s*"+frame.prefix+"\\s*\\]\\s*");
+		text.replace(textToRemove, "");
+		markdown += text;
+		markdown += "\n";
+		break;
+	}
+	case FrameType::Link:
+	{
+		const auto content = takeContent(frame);
+		if(content.contains("[") || content.contains("]"))
+			warnings.emplace_back([]{ qWarning() << "WARNING: found a link whose text contains square brackets. This may interfere with Markdown parsing.\n"; });
+		markdown += "[";
+		markdown += content.trimmed();
+		markdown += "](";
+		markdown += frame.prefix;
+		markdown += ")";
+		break;
+	}
+	case FrameType::Blockquote:
+	{
+		auto blockquote = takeContent(frame).trimmed();
+		blockquote.replace("\n", "\n> ");
+		addNewlineBeforeNodeIfNeeded();
+		markdown += "\n> ";
+		markdown += blockquote;
+		markdown += "\n";
+		break;
+	}
+	case FrameType::Table:
+		break;
+	case FrameType::TableRow:
+		emitTableRow(frame, frames.back());
+		break;
+	case FrameType::TableCell:
+	case FrameType::ListItem:
+		frames.back().items.push_back(takeContent(frame));
+		break;
+	case FrameType::List:
+	{
+		if(markdown.size() > frames.back().bufferStart && markdown.back() != '\n')
+			markdown += '\n';
+		const bool ordered = frame.flag;
+		for(unsigned i = 0; i < frame.items.size(); ++i)
+		{
+			if(ordered)
+				markdown += QString(" %1. ").arg(i+1);
+			else
+				markdown += " - ";
+			markdown += frame.items[i];
+			markdown += '\n';
+		}
+		break;
+	}
+	case FrameType::Sup:
+		// Empty <sup> is serialized as HTML
+		return false;
+	}
+	return true;
+}
+
+bool Converter::run(const QByteArray& xhtml)
+{
+	reader.addData(xhtml);
+	reader.setNamespaceProcessing(false);
+	if(!findBody())
+		return false;
+
+	frames.push_back({FrameType::Body, 0, 0, false, footnotesToRefs, {}, false, {}});
+	while(!frames.empty())
+	{
+		switch(reader.readNext())
+		{
+		case QXmlStreamReader::StartElement:
+			if(!startElement())
+				return false;
+			break;
+		case QXmlStreamReader::EndElement:
+			if(!endElement())
+				return false;
+			break;
+		case QXmlStreamReader::Characters:
+		{
+			// QDomDocument drops text nodes consisting of XML whitespace only, but keeps e.g. U+00A0
+			if(!reader.isCDATA() && reader.isWhitespace())
+				break;
+			if(isStructural() || reader.isCDATA())
+				return false;
+			const auto start = markdown.size();
+			markdown += reader.text();
+			// This mustn't be simplified(), otherwise this will break "text <i>like</i> this"
+			std::replace(markdown.begin() + start, markdown.end(), QChar('\n'), QChar(' '));
+			break;
+		}
+		case QXmlStreamReader::Comment:
+			if(isStructural())
+				return false;
+			addNewlineBeforeNodeIfNeeded();
+			markdown += "<!--";
+			markdown += reader.text();
+			markdown += "-->";
+			break;
+		case QXmlStreamReader::EntityReference:
+			// An entity undeclared in the document, like &nbsp;, is kept as is
+			if(isStructural())
+				return false;
+			markdown += '&';
+			markdown += reader.name();
+			markdown += ';';
+			break;
+		default:
+			// Processing instructions, errors etc.
+			return false;
+		}
+	}
+
+	// A parse error after the body would change what QDomDocument produces
+	while(!reader.atEnd())
+		reader.readNext();
+	return !reader.hasError();
+}
+
+void Converter::emitWarnings() const
+{
+	for(const auto& warn : warnings)
+		warn();
+}
+
+}
+
+std::optional<QString> convertXHTMLToMarkdown(const QByteArray& xhtml, const bool footnotesToRefs)
+{
+	Converter converter(footnotesToRefs);
+	if(!converter.run(xhtml))
+		return std::nullopt;
+	converter.emitWarnings();
+	return converter.takeMarkdown();
+}
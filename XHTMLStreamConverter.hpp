@@ -0,0 +1,31 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#pragma once
+
+#include <optional>
+#include <QString>
+#include <QByteArray>
+
+//! Converts tidied XHTML to Markdown in a single pass over the document, without building
+//! a DOM tree. Constructs that the DOM-based converter keeps as (re-serialized) HTML are not
+//! handled here: std::nullopt is returned for such documents, and nothing is logged, so that
+//! the caller can fall back to the DOM-based converter. On success the result is identical
+//! to that of the DOM-based converter, including the warnings it would emit.
+std::optional<QString> convertXHTMLToMarkdown(const QByteArray& xhtml, bool footnotesToRefs);
@@ -0,0 +1,20 @@
+find_path(LIBUNISTRING_INCLUDE_DIR NAMES unilbrk.h)
+find_library(LIBUNISTRING_LIBRARY NAMES unistring libunistring)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LibUnistring
+    FOUND_VAR
+        LIBUNISTRING_FOUND
+    REQUIRED_VARS
+        LIBUNISTRING_LIBRARY
+        LIBUNISTRING_INCLUDE_DIR
+)
+
+if(LIBUNISTRING_FOUND AND NOT TARGET LibUnistring::LibUnistring)
+    add_library(LibUnistring::LibUnistring UNKNOWN IMPORTED)
+    set_target_properties(LibUnistring::LibUnistring PROPERTIES
+                          IMPORTED_LOCATION "${LIBUNISTRING_LIBRARY}"
+                          INTERFACE_INCLUDE_DIRECTORIES "${LIBUNISTRING_INCLUDE_DIR}")
+endif()
+
+mark_as_advanced(LIBUNISTRING_INCLUDE_DIR LIBUNISTRING_LIBRARY)
@@ -22,34 +22,66 @@
 #include <QString>
 #include <vector>
 #include <string>
+#include <QFile>
+#include <QLoggingCategory>
 #include <QCoreApplication>
 #include "SkyCultureConverter.hpp"
+#include "Diagnostics.hpp"
 #include "Utils.hpp"
+#include "Regex.hpp"
+#include "TarArchive.hpp"
 #include <QMetaEnum>
 
 int usage(const char *argv0, const int ret)
 {
     auto &out = ret ? std::cerr : std::cout;
-    out << "Usage: " << argv0 << " [options...] skyCultureDir outputDir [skyCulturePoDir]\n"
+    out << "Usage: " << argv0 << " [options...] skyCultureDir|skyCulture.tar[.gz] outputDir [skyCulturePoDir]\n"
         << "Options:\n"
         << "  --footnotes-to-references  Try to convert footnotes to references\n"
         << "  --untrans-names-are-native Record untranslatable star/DSO names as native names\n"
         << "  --native-locale LOCALE     Use *_names.LOCALE.fab as a source for \"native\" constellation names (the\n"
            "                             middle column in *_names.eng.fab will be moved to the \"pronounce\" entry.\n"
-        << "  --translated-md            Generate localized Markdown files (for checking translations)\n";
+        << "  --translated-md            Generate localized Markdown files (for checking translations)\n"
+        << "  --blob-store DIR           Keep illustrations in a content-addressed store in DIR, shared between\n"
+           "                             conversions, and hardlink or reflink them into the output. Don't edit\n"
+           "                             hardlinked illustrations in place, as this would alter the store.\n"
+        << "  --max-texture-size N       Downscale constellation art so that it's at most N pixels wide and high\n"
+        << "  --image-cache DIR          Cache downscaled illustrations in DIR to avoid re-encoding them next time\n"
+        << "  --md-cache DIR             Cache the Markdown converted from the descriptions in DIR\n"
+        << "  --native-po-writer         Write the .po files with the built-in serializer instead of libgettextpo\n"
+        << "  --generic-boundaries FILE  Read the generic constellation boundaries from FILE instead of from\n"
+           "                             data/constellation_boundaries.dat two levels above skyCultureDir. Needed\n"
+           "                             for archives of sky cultures that use the generic boundaries.\n"
+        << "  --output-tar               Write the output into a tar archive at outputDir, compressed with gzip if it\n"
+           "                             ends with .gz or .tgz. Nothing else is written, and --blob-store is ignored.\n"
+        << "  -q, --quiet                Print only errors\n"
+        << "  -v                         Also print the progress of the conversion\n"
+        << "  -vv                        Also print debugging messages\n"
+        << "  --max-messages N           Print at most N distinct messages, repeated messages are printed once anyway\n"
+        << "  --diagnostics FILE         Write all the messages to FILE as JSON, with their severities, locations and codes\n"
+        << "  --profile-regex            Print how many times each regular expression was used and the time spent in it\n";
     return ret;
 }
 
 int main(int argc, char **argv)
 {
     QCoreApplication app(argc, argv);
-    QString inDir, outDir, poDir, nativeLocale;
+    QString inDir, outDir, poDir, nativeLocale, blobStoreDir, maxTextureSize, imageCacheDir, markdownCacheDir, genericBoundariesFile;
+    QString maxMessages, diagnosticsFile;
+    auto verbosity = Diagnostics::Severity::Warning;
     bool footnotesToRefs = false, genTranslatedMD = false, convertUntranslatableNamesToNative = false;
+    bool nativePoWriter = false, outputTar = false;
     // parse arguments
     std::vector<QString> args(argv + 1, argv + argc);
+    QString *optionValue = nullptr; // where to store the argument following an option that takes a value
     for (const auto &arg : args)
     {
-        if (!arg.isEmpty() && arg[0] != '-')
+        if (optionValue)
+        {
+            *optionValue = arg;
+            optionValue = nullptr;
+        }
+        else if (!arg.isEmpty() && arg[0] != '-')
         {
             if (inDir.isEmpty())
                 inDir = arg;
@@ -67,13 +99,33 @@ int main(int argc, char **argv)
         else if (arg == "--untrans-names-are-native")
             convertUntranslatableNamesToNative = true;
         else if (arg == "--native-locale")
-        {
-            static bool nextIsLocale = false;
-            nextIsLocale = !nextIsLocale;
-            if (nextIsLocale)
-                continue;
-            nativeLocale = arg;
-        }
+            optionValue = &nativeLocale;
+        else if (arg == "--blob-store")
+            optionValue = &blobStoreDir;
+        else if (arg == "--max-texture-size")
+            optionValue = &maxTextureSize;
+        else if (arg == "--image-cache")
+            optionValue = &imageCacheDir;
+        else if (arg == "--md-cache")
+            optionValue = &markdownCacheDir;
+        else if (arg == "--native-po-writer")
+            nativePoWriter = true;
+        else if (arg == "--generic-boundaries")
+            optionValue = &genericBoundariesFile;
+        else if (arg == "--output-tar")
+            outputTar = true;
+        else if (arg == "--quiet" || arg == "-q")
+            verbosity = Diagnostics::Severity::Error;
+        else if (arg == "-v")
+            verbosity = Diagnostics::Severity::Info;
+        else if (arg == "-vv")
+            verbosity = Diagnostics::Severity::Debug;
+        else if (arg == "--max-messages")
+            optionValue = &maxMessages;
+        else if (arg == "--diagnostics")
+            optionValue = &diagnosticsFile;
+        else if (arg == "--profile-regex")
+            Regex::setProfilingEnabled(true);
         else if (arg == "--help" || arg == "-h")
         {
             return usage(argv[0], 0);
@@ -81,10 +133,69 @@ int main(int argc, char **argv)
         else
             return usage(argv[0], 1);
     }
-    
-    auto result = SkyCultureConverter::convert(inDir, outDir, poDir, nativeLocale,
-                                               footnotesToRefs, genTranslatedMD,
-                                               convertUntranslatableNamesToNative);
+    if (optionValue)
+        return usage(argv[0], 1);
+    int maxTextureEdge = 0;
+    if (!maxTextureSize.isEmpty())
+    {
+        bool ok = false;
+        maxTextureEdge = maxTextureSize.toInt(&ok);
+        if (!ok || maxTextureEdge <= 0)
+            return usage(argv[0], 1);
+    }
+
+    int maxMessageCount = -1;
+    if (!maxMessages.isEmpty())
+    {
+        bool ok = false;
+        maxMessageCount = maxMessages.toInt(&ok);
+        if (!ok || maxMessageCount < 0)
+            return usage(argv[0], 1);
+    }
+
+    // Unless all the messages go to a file, the ones that won't be printed aren't even formatted
+    const auto collectedSeverity = diagnosticsFile.isEmpty() ? verbosity : Diagnostics::Severity::Debug;
+    if (collectedSeverity > Diagnostics::Severity::Debug)
+        QLoggingCategory::setFilterRules(collectedSeverity > Diagnostics::Severity::Info ? "*.debug=false\n*.info=false"
+                                                                                        : "*.debug=false");
+    Diagnostics::Collector diagnostics;
+    diagnostics.setMinSeverity(collectedSeverity);
+    diagnostics.setConsoleSink(verbosity, maxMessageCount);
+    SkyCultureConverter::ConvertOptions options;
+    options.poDir = poDir;
+    options.nativeLocale = nativeLocale;
+    options.footnotesToRefs = footnotesToRefs;
+    options.genTranslatedMD = genTranslatedMD;
+    options.convertUntranslatableNamesToNative = convertUntranslatableNamesToNative;
+    options.blobStoreDir = blobStoreDir;
+    options.maxTextureSize = maxTextureEdge;
+    options.imageCacheDir = imageCacheDir;
+    options.nativePoWriter = nativePoWriter;
+    options.markdownCacheDir = markdownCacheDir;
+    options.genericBoundariesFile = genericBoundariesFile;
+    options.diagnostics = &diagnostics;
+    // A directory converted into a directory doesn't need to go through memory
+    auto result = outputTar || TarArchive::isArchivePath(inDir)
+                      ? SkyCultureConverter::convertArchive(inDir, outDir, outputTar, options)
+                      : SkyCultureConverter::convert(inDir, outDir, options);
+
+    const int warningCount = diagnostics.count(Diagnostics::Severity::Warning);
+    const int errorCount = diagnostics.count(Diagnostics::Severity::Error);
+    if (warningCount || errorCount)
+        std::cerr << "SkyCultureConverter::\t" << errorCount << " errors, " << warningCount << " warnings\n";
+    if (!diagnosticsFile.isEmpty())
+    {
+        QFile file(diagnosticsFile);
+        const auto json = diagnostics.toJSON();
+        if (!file.open(QFile::WriteOnly) || file.write(json) != json.size() || !file.flush())
+            std::cerr << "SkyCultureConverter::\tFailed to write " << diagnosticsFile.toStdString() << "\n";
+    }
+
+    if (Regex::profilingEnabled())
+    {
+        QLoggingCategory::setFilterRules(QString());
+        Regex::printProfile();
+    }
 
     if (result != SkyCultureConverter::ReturnValue::CONVERT_SUCCESS)
     {
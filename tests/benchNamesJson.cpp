@@ -0,0 +1,150 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include "FileSystem.hpp"
+#include "NamesOldLoader.hpp"
+
+// Every heap allocation of the process is counted: operator new here, and on glibc also the
+// malloc() family, which Qt's containers use directly
+namespace
+{
+std::atomic<long long> allocationCount{0};
+}
+
+#ifdef __GLIBC__
+extern "C"
+{
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(const std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+void* calloc(const std::size_t count, const std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+void* realloc(void* const ptr, const std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(ptr, size);
+}
+void free(void* const ptr)
+{
+	__libc_free(ptr);
+}
+}
+#endif
+
+void* operator new(const std::size_t size)
+{
+#ifndef __GLIBC__
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+#endif
+	if(void* const ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+void operator delete(void* const ptr) noexcept { std::free(ptr); }
+void operator delete(void* const ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+
+// Discards the output, so that only the allocations of the serialization itself are counted
+class NullBuffer : public std::streambuf
+{
+protected:
+	std::streamsize xsputn(const char*, const std::streamsize count) override { return count; }
+	int_type overflow(const int_type c) override { return traits_type::not_eof(c); }
+};
+
+constexpr int starCount = 5000;
+constexpr int dsoCount = 1000;
+constexpr int planetCount = 8;
+
+MemoryFileSystem::Files sampleNames()
+{
+	QByteArray stars = "# TRANSLATORS: names of stars\n";
+	for(int n = 1; n <= starCount; ++n)
+		stars += QByteArray::number(n) + "|_(\"Star " + QByteArray::number(n) + " \\\"quoted\\\"\") 1,2\n";
+	QByteArray dsos;
+	for(int n = 1; n <= dsoCount; ++n)
+		dsos += "NGC " + QByteArray::number(n) + "|_(\"Nebula " + QByteArray::number(n) + "\")\n";
+	QByteArray planets;
+	for(int n = 1; n <= planetCount; ++n)
+		planets += "Planet" + QByteArray::number(n) + " \"Native\" _(\"Planet " + QByteArray::number(n) + "\")\n";
+	return {{"star_names.fab", stars}, {"dso_names.fab", dsos}, {"planet_names.fab", planets}};
+}
+
+}
+
+class BenchNamesJson : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void dumpJSON();
+	void allocationsPerName();
+private:
+	MemoryFileSystem fs{"culture", sampleNames()};
+	NamesOldLoader loader;
+};
+
+void BenchNamesJson::initTestCase()
+{
+	loader.setFileSystem(fs);
+	loader.load("culture", "", false);
+}
+
+void BenchNamesJson::dumpJSON()
+{
+	NullBuffer buffer;
+	std::ostream s(&buffer);
+	QBENCHMARK
+	{
+		QVERIFY(loader.dumpJSON(s));
+	}
+}
+
+void BenchNamesJson::allocationsPerName()
+{
+	NullBuffer buffer;
+	std::ostream s(&buffer);
+	const auto before = allocationCount.load();
+	QVERIFY(loader.dumpJSON(s));
+	const auto allocations = allocationCount.load() - before;
+
+	constexpr int nameCount = starCount + dsoCount + planetCount;
+	qInfo().nospace() << allocations << " allocations for " << nameCount << " names";
+	QTest::setBenchmarkResult(qreal(allocations) / nameCount, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(BenchNamesJson)
+#include "benchNamesJson.moc"
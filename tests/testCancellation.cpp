@@ -0,0 +1,129 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <QDir>
+#include <QTemporaryDir>
+#include "Progress.hpp"
+#include "Diagnostics.hpp"
+#include "SkyCultureConverter.hpp"
+
+namespace
+{
+
+const std::pair<const char*, QByteArray> cultureFiles[] = {
+	{"info.ini",
+	 "[info]\n"
+	 "name = Test\n"
+	 "author = Stellarium's team\n"
+	 "license = CC BY-SA 4.0\n"
+	 "region = World\n"
+	 "classification = traditional\n"
+	 "boundaries = none\n"},
+	{"constellationship.fab", "Ori 2 26727 26311 26311 25930\n"},
+	{"constellation_names.eng.fab", "Ori \"Orion\" _(\"Orion\")\n"},
+	{"asterism_lines.fab", "Belt 1 1 26727 26311\n"},
+	{"asterism_names.eng.fab", "Belt _(\"Belt\")\n"},
+	{"star_names.fab", "26727|_(\"Alnitak\")\n"},
+	{"description.en.utf8",
+	 "<h1>Test</h1>\n"
+	 "<h2>Introduction</h2>\n<p>A sky culture to be cancelled.</p>\n"
+	 "<h2>References</h2>\n<ul><li>None</li></ul>\n"},
+};
+
+// The stages after which the conversion checks for cancellation
+const char*const cancellableStages[] = {"info", "asterisms", "constellations", "names", "index",
+                                        "description", "output", "illustrations"};
+
+}
+
+class TestCancellation : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cancelFromProgress_data();
+	void cancelFromProgress();
+private:
+	QTemporaryDir dir;
+	QString inputDir;
+};
+
+void TestCancellation::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	inputDir = dir.filePath("input/test");
+	QVERIFY(QDir().mkpath(inputDir));
+	for(const auto& [name, data] : cultureFiles)
+	{
+		QFile file(inputDir + "/" + name);
+		QVERIFY(file.open(QFile::WriteOnly));
+		QCOMPARE(file.write(data), qint64(data.size()));
+	}
+}
+
+void TestCancellation::cancelFromProgress_data()
+{
+	QTest::addColumn<QString>("stage");
+	QTest::newRow("not cancelled") << QString();
+	for(const char* stage : cancellableStages)
+		QTest::newRow(stage) << QString(stage);
+}
+
+void TestCancellation::cancelFromProgress()
+{
+	QFETCH(QString, stage);
+	const auto outputDir = dir.filePath("output-" + (stage.isEmpty() ? QString("complete") : stage));
+
+	CancellationToken token;
+	QStringList stagesSeen;
+	Diagnostics::Collector diagnostics;
+	SkyCultureConverter::ConvertOptions options;
+	options.diagnostics = &diagnostics;
+	options.cancellation = &token;
+	options.progress = [&](const QString& currentStage, const QString&, int, int) {
+		if(!stagesSeen.contains(currentStage))
+			stagesSeen += currentStage;
+		if(currentStage == stage)
+			token.cancel();
+	};
+
+	const auto ret = SkyCultureConverter::convert(inputDir, outputDir, options);
+	if(stage.isEmpty())
+	{
+		QCOMPARE(ret, SkyCultureConverter::ReturnValue::CONVERT_SUCCESS);
+		QVERIFY(QFileInfo(outputDir + "/index.json").isFile());
+		// Every stage is reached, or else the rows cancelling at a missing one would test nothing
+		for(const char* cancellableStage : cancellableStages)
+			QVERIFY2(stagesSeen.contains(cancellableStage), cancellableStage);
+	}
+	else
+	{
+		QCOMPARE(ret, SkyCultureConverter::ReturnValue::ERR_CANCELLED);
+		QVERIFY(stagesSeen.contains(stage));
+		QVERIFY(!QFileInfo::exists(outputDir));
+	}
+	// The staging directory is gone either way
+	const auto leftovers = QDir(dir.path()).entryList({QFileInfo(outputDir).fileName() + ".tmp-*"},
+	                                                   QDir::AllEntries | QDir::Hidden | QDir::System);
+	QCOMPARE(leftovers, QStringList());
+}
+
+QTEST_GUILESS_MAIN(TestCancellation)
+#include "testCancellation.moc"
@@ -0,0 +1,167 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include "ConverterContext.hpp"
+
+class TestConverterContext : public QObject
+{
+	Q_OBJECT
+private slots:
+	void init();
+	void reusesUnchangedFile();
+	void rereadsModifiedFile();
+	void rereadsResizedFile();
+	void separatesTagsAndTypes();
+	void clearDropsEntries();
+	void skipsMissingFilesAndNulls();
+private:
+	std::shared_ptr<const QByteArray> cached(const QString& tag = {});
+	void write(const QByteArray& data);
+
+	QTemporaryDir dir;
+	QString path;
+	ConverterContext context;
+	int reads = 0;
+};
+
+void TestConverterContext::init()
+{
+	QVERIFY(dir.isValid());
+	path = dir.filePath(QTest::currentTestFunction() + QString(".dat"));
+	context.clear();
+	reads = 0;
+	write("contents");
+}
+
+// Reads the file through the context, counting the actual reads
+std::shared_ptr<const QByteArray> TestConverterContext::cached(const QString& tag)
+{
+	return context.cachedFile<QByteArray>(path, tag, [this](const QString& filePath) {
+		++reads;
+		QFile file(filePath);
+		return file.open(QFile::ReadOnly) ? std::make_shared<const QByteArray>(file.readAll()) : nullptr;
+	});
+}
+
+void TestConverterContext::write(const QByteArray& data)
+{
+	QFile file(path);
+	QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+	QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+void TestConverterContext::reusesUnchangedFile()
+{
+	const auto first = cached();
+	QCOMPARE(*first, QByteArray("contents"));
+	const auto second = cached();
+	QCOMPARE(reads, 1);
+	QCOMPARE(second, first);
+}
+
+void TestConverterContext::rereadsModifiedFile()
+{
+	cached();
+	// Same size, different modification time
+	write("CONTENTS");
+	QFile file(path);
+	QVERIFY(file.open(QFile::ReadWrite));
+	QVERIFY(file.setFileTime(QDateTime::currentDateTimeUtc().addSecs(-3600), QFileDevice::FileModificationTime));
+	file.close();
+
+	QCOMPARE(*cached(), QByteArray("CONTENTS"));
+	QCOMPARE(reads, 2);
+	cached();
+	QCOMPARE(reads, 2);
+}
+
+void TestConverterContext::rereadsResizedFile()
+{
+	// Keep the modification time, so that only the size tells the versions apart
+	const auto modified = QFileInfo(path).lastModified();
+	cached();
+	write("longer contents");
+	QFile file(path);
+	QVERIFY(file.open(QFile::ReadWrite));
+	QVERIFY(file.setFileTime(modified, QFileDevice::FileModificationTime));
+	file.close();
+
+	QCOMPARE(*cached(), QByteArray("longer contents"));
+	QCOMPARE(reads, 2);
+}
+
+void TestConverterContext::separatesTagsAndTypes()
+{
+	cached("one");
+	cached("two");
+	cached();
+	QCOMPARE(reads, 3);
+	cached("one");
+	cached("two");
+	cached();
+	QCOMPARE(reads, 3);
+
+	// Another type made of the same file with the same tag
+	int otherReads = 0;
+	const auto size = context.cachedFile<qint64>(path, "one", [&otherReads](const QString& filePath) {
+		++otherReads;
+		return std::make_shared<const qint64>(QFileInfo(filePath).size());
+	});
+	QCOMPARE(*size, qint64(8));
+	QCOMPARE(otherReads, 1);
+	QCOMPARE(*cached("one"), QByteArray("contents"));
+	QCOMPARE(reads, 3);
+}
+
+void TestConverterContext::clearDropsEntries()
+{
+	const auto first = cached();
+	cached("tagged");
+	context.clear();
+	const auto second = cached();
+	cached("tagged");
+	QCOMPARE(reads, 4);
+	QVERIFY(second != first);
+	// The values handed out before stay valid
+	QCOMPARE(*first, QByteArray("contents"));
+}
+
+void TestConverterContext::skipsMissingFilesAndNulls()
+{
+	path = dir.filePath("missing.dat");
+	QVERIFY(!cached());
+	QVERIFY(!cached());
+	QCOMPARE(reads, 2);
+
+	// A file the reader fails on is tried again the next time
+	write("contents");
+	int failedReads = 0;
+	const auto failingRead = [&failedReads](const QString&) {
+		++failedReads;
+		return std::shared_ptr<const QByteArray>();
+	};
+	QVERIFY(!context.cachedFile<QByteArray>(path, failingRead));
+	QVERIFY(!context.cachedFile<QByteArray>(path, failingRead));
+	QCOMPARE(failedReads, 2);
+}
+
+QTEST_GUILESS_MAIN(TestConverterContext)
+#include "testConverterContext.moc"
@@ -0,0 +1,266 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <thread>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include "Diagnostics.hpp"
+
+using Diagnostics::Collector;
+using Diagnostics::Record;
+using Diagnostics::Severity;
+
+namespace
+{
+
+Record record(const QString& message, const Severity severity = Severity::Warning)
+{
+	return {severity, "file.fab", 1, "code", message};
+}
+
+}
+
+class TestDiagnostics : public QObject
+{
+	Q_OBJECT
+private slots:
+	void dedupe();
+	void minSeverity();
+	void messageLimit_data();
+	void messageLimit();
+	void toJSON();
+	void nestedScopes();
+	void scopeInAnotherThread();
+	void qtMessages();
+};
+
+void TestDiagnostics::dedupe()
+{
+	Collector collector;
+	collector.report(record("first"));
+	collector.report(record("second"));
+	collector.report(record("first"));
+	// A different severity, file or line makes a different record
+	collector.report(record("first", Severity::Error));
+	collector.report({Severity::Warning, "file.fab", 2, "code", "first"});
+	collector.report({Severity::Warning, "other.fab", 1, "code", "first"});
+	collector.report(record("first"));
+
+	const auto records = collector.records();
+	QCOMPARE(records.size(), std::size_t(5));
+	QCOMPARE(records[0].message, QString("first"));
+	QCOMPARE(records[0].count, 3);
+	QCOMPARE(records[1].message, QString("second"));
+	QCOMPARE(records[1].count, 1);
+	QCOMPARE(records[2].severity, Severity::Error);
+	QCOMPARE(records[3].line, 2);
+	QCOMPARE(records[4].file, QString("other.fab"));
+
+	QCOMPARE(collector.count(Severity::Warning), 6);
+	QCOMPARE(collector.count(Severity::Error), 1);
+	QCOMPARE(collector.count(Severity::Info), 0);
+}
+
+void TestDiagnostics::minSeverity()
+{
+	Collector collector;
+	collector.setMinSeverity(Severity::Warning);
+	collector.setConsoleSink(Severity::Debug);
+	QCOMPARE(collector.report(record("ignored", Severity::Info)), Collector::ConsoleAction::None);
+	QCOMPARE(collector.report(record("kept")), Collector::ConsoleAction::Print);
+	QCOMPARE(collector.records().size(), std::size_t(1));
+	QCOMPARE(collector.count(Severity::Info), 0);
+	QCOMPARE(collector.count(Severity::Warning), 1);
+}
+
+void TestDiagnostics::messageLimit_data()
+{
+	QTest::addColumn<int>("maxMessages");
+	QTest::addColumn<int>("messages");
+	QTest::addColumn<int>("printed");
+	QTest::addColumn<bool>("noted");
+
+	QTest::newRow("fewer") << 3 << 2 << 2 << false;
+	QTest::newRow("exactly the limit") << 3 << 3 << 3 << false;
+	QTest::newRow("one more") << 3 << 4 << 3 << true;
+	QTest::newRow("many more") << 3 << 10 << 3 << true;
+	QTest::newRow("zero") << 0 << 2 << 0 << true;
+	QTest::newRow("unlimited") << -1 << 10 << 10 << false;
+}
+
+void TestDiagnostics::messageLimit()
+{
+	QFETCH(int, maxMessages);
+	QFETCH(int, messages);
+	QFETCH(int, printed);
+	QFETCH(bool, noted);
+
+	Collector collector;
+	collector.setConsoleSink(Severity::Warning, maxMessages);
+	// Neither repeats nor records below the console severity count towards the limit
+	QCOMPARE(collector.report(record("info", Severity::Info)), Collector::ConsoleAction::None);
+	int printCount = 0, noteCount = 0;
+	for(int n = 0; n < messages; ++n)
+	{
+		for(int repeat = 0; repeat < 2; ++repeat)
+		{
+			const auto action = collector.report(record(QString("message %1").arg(n)));
+			if(repeat)
+				QCOMPARE(action, Collector::ConsoleAction::None);
+			if(action == Collector::ConsoleAction::Print)
+				++printCount;
+			else if(action == Collector::ConsoleAction::NoteSuppression)
+			{
+				QCOMPARE(n, maxMessages);
+				++noteCount;
+			}
+		}
+	}
+	QCOMPARE(printCount, printed);
+	QCOMPARE(noteCount, int(noted));
+	// The suppressed records are still collected
+	QCOMPARE(collector.records().size(), std::size_t(messages + 1));
+}
+
+void TestDiagnostics::toJSON()
+{
+	QCOMPARE(Collector().toJSON(), QByteArray("[]\n"));
+
+	const QString message = "quote \" backslash \\ line\nbreak tab\t control \x01 non-ASCII é中";
+	Collector collector;
+	{
+		Diagnostics::Scope scope({&collector, "cul\"ture", "st\\age"});
+		Diagnostics::warning("co\"de", message, "dir\\file.fab", 12);
+		Diagnostics::warning("co\"de", message, "dir\\file.fab", 12);
+		Diagnostics::error("other", "second");
+	}
+
+	const auto json = collector.toJSON();
+	QJsonParseError error;
+	const auto document = QJsonDocument::fromJson(json, &error);
+	QCOMPARE(error.error, QJsonParseError::NoError);
+	const auto array = document.array();
+	QCOMPARE(array.size(), 2);
+
+	const auto first = array[0].toObject();
+	QCOMPARE(first.size(), 8);
+	QCOMPARE(first["severity"].toString(), QString("warning"));
+	QCOMPARE(first["culture"].toString(), QString("cul\"ture"));
+	QCOMPARE(first["stage"].toString(), QString("st\\age"));
+	QCOMPARE(first["file"].toString(), QString("dir\\file.fab"));
+	QCOMPARE(first["line"].toInt(), 12);
+	QCOMPARE(first["code"].toString(), QString("co\"de"));
+	QCOMPARE(first["message"].toString(), message);
+	QCOMPARE(first["count"].toInt(), 2);
+
+	const auto second = array[1].toObject();
+	QCOMPARE(second["severity"].toString(), QString("error"));
+	QCOMPARE(second["file"].toString(), QString());
+	QCOMPARE(second["line"].toInt(), 0);
+	QCOMPARE(second["count"].toInt(), 1);
+}
+
+void TestDiagnostics::nestedScopes()
+{
+	Collector outerCollector, innerCollector;
+	{
+		Diagnostics::Scope outer({&outerCollector, "outer", "names"});
+		Diagnostics::warning("code", "before");
+		{
+			Diagnostics::Scope inner({&innerCollector, "inner", "art"});
+			QCOMPARE(Diagnostics::Context::current().culture, QString("inner"));
+			Diagnostics::setStage("description");
+			Diagnostics::warning("code", "inside");
+		}
+		// The stage set in the inner scope doesn't leak out of it
+		QCOMPARE(Diagnostics::Context::current().stage, QString("names"));
+		Diagnostics::warning("code", "after");
+	}
+	QVERIFY(!Diagnostics::Context::current().collector);
+
+	const auto outerRecords = outerCollector.records();
+	QCOMPARE(outerRecords.size(), std::size_t(2));
+	QCOMPARE(outerRecords[0].message, QString("before"));
+	QCOMPARE(outerRecords[1].message, QString("after"));
+	QCOMPARE(outerRecords[1].culture, QString("outer"));
+	QCOMPARE(outerRecords[1].stage, QString("names"));
+
+	const auto innerRecords = innerCollector.records();
+	QCOMPARE(innerRecords.size(), std::size_t(1));
+	QCOMPARE(innerRecords[0].message, QString("inside"));
+	QCOMPARE(innerRecords[0].culture, QString("inner"));
+	QCOMPARE(innerRecords[0].stage, QString("description"));
+}
+
+void TestDiagnostics::scopeInAnotherThread()
+{
+	Collector collector;
+	Diagnostics::Scope scope({&collector, "western", "names"});
+
+	// The context is handed over explicitly, a thread doesn't inherit it
+	const auto context = Diagnostics::Context::current();
+	Diagnostics::Context contextInThread{&collector};
+	QTest::ignoreMessage(QtWarningMsg, "outside of any scope");
+	std::thread([&] {
+		contextInThread = Diagnostics::Context::current();
+		Diagnostics::warning("code", "outside of any scope");
+		Diagnostics::Scope threadScope(context);
+		Diagnostics::warning("code", "from the thread");
+		qWarning() << "logged from the thread";
+	}).join();
+	QVERIFY(!contextInThread.collector);
+
+	const auto records = collector.records();
+	QCOMPARE(records.size(), std::size_t(2));
+	QCOMPARE(records[0].message, QString("from the thread"));
+	QCOMPARE(records[1].code, QString("log"));
+	for(const auto& record : records)
+	{
+		QCOMPARE(record.culture, QString("western"));
+		QCOMPARE(record.stage, QString("names"));
+	}
+}
+
+void TestDiagnostics::qtMessages()
+{
+	Collector collector;
+	{
+		Diagnostics::Scope scope({&collector, "western", "names"});
+		qInfo() << "info";
+		qWarning() << "warning";
+		qCritical() << "critical";
+	}
+	// Without a scope the messages go to the previous handler again
+	QTest::ignoreMessage(QtWarningMsg, "not collected");
+	qWarning() << "not collected";
+
+	const auto records = collector.records();
+	QCOMPARE(records.size(), std::size_t(3));
+	QCOMPARE(records[0].severity, Severity::Info);
+	QCOMPARE(records[1].severity, Severity::Warning);
+	QCOMPARE(records[2].severity, Severity::Error);
+	for(const auto& record : records)
+		QCOMPARE(record.code, QString("log"));
+	QCOMPARE(records[1].message, QString("warning"));
+}
+
+QTEST_GUILESS_MAIN(TestDiagnostics)
+#include "testDiagnostics.moc"
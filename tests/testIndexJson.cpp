@@ -0,0 +1,131 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <sstream>
+#include "IndexJson.hpp"
+#include "OutputDir.hpp"
+#include "FileSystem.hpp"
+#include "NamesOldLoader.hpp"
+#include "AsterismOldLoader.hpp"
+#include "ConstellationOldLoader.hpp"
+
+namespace
+{
+
+const QString cultureDir = "culture";
+const std::string infoSection = "{\n  \"id\": \"test\",\n  \"region\": \"World\",\n";
+
+const QByteArray constellationLines =
+	"# Lines\n"
+	"Ori 2 26727 26311 26311 25930\n"
+	"UMa 1 54061 53910\n";
+const QByteArray constellationNames =
+	"Ori \"Orion\" _(\"Orion\") 1\n"
+	"UMa \"Ursa Major\" _(\"Great Bear\")\n";
+
+// A culture that has all the sections of index.json
+MemoryFileSystem::Files fullCulture()
+{
+	return {
+		{"constellationship.fab", constellationLines},
+		{"constellation_names.eng.fab", constellationNames},
+		{"asterism_lines.fab", "Belt 1 1 26727 26311\nTri 1 2 24436 27989 27989 26311\n"},
+		{"asterism_names.eng.fab", "Belt _(\"Belt\") 2\nTri _(\"Triangle\")\n"},
+		{"star_names.fab", "26727|_(\"Alnitak\") 1\n27989|_(\"Betelgeuse\")\n"},
+		{"dso_names.fab", "M42|_(\"Great Orion Nebula\")\n"},
+		{"planet_names.fab", "Sun \"Sol\" _(\"Sun\")\nMoon \"Luna\" _(\"Moon\")\nMoon \"Selene\" _(\"Selene\")\n"},
+	};
+}
+
+// A culture whose asterism and names sections come out empty
+MemoryFileSystem::Files constellationsOnlyCulture()
+{
+	return {
+		{"constellationship.fab", constellationLines},
+		{"constellation_names.eng.fab", constellationNames},
+	};
+}
+
+}
+
+class TestIndexJson : public QObject
+{
+	Q_OBJECT
+private slots:
+	void parallelMatchesSerial_data();
+	void parallelMatchesSerial();
+};
+
+void TestIndexJson::parallelMatchesSerial_data()
+{
+	QTest::addColumn<bool>("hasAllSections");
+	QTest::newRow("full") << true;
+	QTest::newRow("constellations only") << false;
+}
+
+void TestIndexJson::parallelMatchesSerial()
+{
+	QFETCH(bool, hasAllSections);
+	const MemoryFileSystem fs(cultureDir, hasAllSections ? fullCulture() : constellationsOnlyCulture());
+	OutputDir output{OutputDir::InMemory{}};
+	output.setSourceFileSystem(fs);
+
+	AsterismOldLoader aLoader;
+	aLoader.setFileSystem(fs);
+	aLoader.load(cultureDir, "test");
+	ConstellationOldLoader cLoader;
+	cLoader.setFileSystem(fs);
+	cLoader.setBoundariesType("none");
+	cLoader.load(cultureDir, output, "");
+	NamesOldLoader nLoader;
+	nLoader.setFileSystem(fs);
+	nLoader.load(cultureDir, "", false);
+
+	// Serially, as all the sections were written into one stream before they were parallelized
+	std::stringstream out;
+	out << infoSection;
+	aLoader.dumpJSON(out);
+	cLoader.dumpJSON(out);
+	nLoader.dumpJSON(out);
+	auto serial = std::move(out).str();
+	if(serial.ends_with(",\n"))
+		serial.resize(serial.size() - 2);
+	serial += "\n}\n";
+
+	auto asterisms = dumpSectionAsync(aLoader);
+	auto constellations = dumpSectionAsync(cLoader);
+	auto names = dumpSectionAsync(nLoader);
+	std::vector<std::string> sections;
+	sections.push_back(infoSection);
+	sections.push_back(asterisms.get());
+	sections.push_back(constellations.get());
+	sections.push_back(names.get());
+	if(!hasAllSections)
+	{
+		QVERIFY(sections[1].empty());
+		QVERIFY(sections[3].empty());
+	}
+	const auto parallel = joinSections(sections);
+
+	QCOMPARE(QByteArray::fromStdString(parallel), QByteArray::fromStdString(serial));
+}
+
+QTEST_GUILESS_MAIN(TestIndexJson)
+#include "testIndexJson.moc"
@@ -0,0 +1,126 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <QDir>
+#include <QSettings>
+#include <QTemporaryDir>
+#include "Utils.hpp"
+
+namespace
+{
+
+// Written like the info.ini files shipped with the sky cultures of Stellarium
+const std::pair<const char*, QByteArray> samples[] = {
+	{"western",
+	 "[info]\n"
+	 "name = Western\n"
+	 "author = Stellarium's team\n"
+	 "credit = \n"
+	 "license = GPL+FAL\n"
+	 "region = World\n"
+	 "classification = traditional\n"
+	 "boundaries = iau\n"},
+	{"quoted",
+	 "; Sky culture description\n"
+	 "[info]\n"
+	 "name = \"Chinese (Medieval)\"\n"
+	 "author = \"Sun Xiaochun, Jacob Kistemaker\"\n"
+	 "credit = \"Ideas and translations by \\\"Sun\\\"\"\n"
+	 "license = CC BY-SA 4.0\n"
+	 "region = Asia\n"
+	 "classification = historical\n"
+	 "boundaries = own\n"},
+	{"unquoted list",
+	 "[info]\n"
+	 "name = Lokono\n"
+	 "author = Jan Smith, Alice Brown\n"
+	 "region = South America\n"},
+	{"non-ASCII and CRLF",
+	 "[info]\r\n"
+	 "name = Māori\r\n"
+	 "author = Stellarium's team  ; trailing comment\r\n"
+	 "region = Oceania\r\n"
+	 "classification = ethnographic\r\n"},
+};
+
+}
+
+class TestInfoIni : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void matchesQSettings_data();
+	void matchesQSettings();
+private:
+	QTemporaryDir dir;
+};
+
+void TestInfoIni::initTestCase()
+{
+	QVERIFY(dir.isValid());
+}
+
+void TestInfoIni::matchesQSettings_data()
+{
+	QTest::addColumn<QByteArray>("data");
+	const QByteArray bom = "\xEF\xBB\xBF";
+	for(const auto& [name, data] : samples)
+	{
+		QTest::newRow(name) << data;
+		QTest::newRow((name + QByteArray(" with BOM")).constData()) << bom + data;
+	}
+
+	// The sky cultures of a Stellarium source tree, if one is given, e.g. STELLARIUM_SKYCULTURES=~/stellarium/skycultures
+	const auto skyculturesDir = qEnvironmentVariable("STELLARIUM_SKYCULTURES");
+	if(skyculturesDir.isEmpty())
+		return;
+	const QDir skycultures(skyculturesDir);
+	for(const auto& culture : skycultures.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+	{
+		QFile file(skycultures.filePath(culture + "/info.ini"));
+		if(file.open(QFile::ReadOnly))
+			QTest::newRow(culture.toUtf8().constData()) << file.readAll();
+	}
+}
+
+void TestInfoIni::matchesQSettings()
+{
+	QFETCH(QByteArray, data);
+	const auto path = dir.filePath(QTest::currentDataTag() + QString(".ini"));
+	QFile file(path);
+	QVERIFY(file.open(QFile::WriteOnly));
+	QCOMPARE(file.write(data), qint64(data.size()));
+	file.close();
+
+	const QSettings settings(path, QSettings::IniFormat);
+	QCOMPARE(settings.status(), QSettings::NoError);
+	const auto values = parseIni(data);
+	auto keys = settings.allKeys();
+	auto parsedKeys = values.keys();
+	keys.sort();
+	parsedKeys.sort();
+	QCOMPARE(parsedKeys, keys);
+	for(const auto& key : keys)
+		QCOMPARE(values.value(key), settings.value(key).toString());
+}
+
+QTEST_GUILESS_MAIN(TestInfoIni)
+#include "testInfoIni.moc"
@@ -0,0 +1,138 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <functional>
+#include "Diagnostics.hpp"
+#include "DescriptionOldLoader.hpp"
+#include "XHTMLStreamConverter.hpp"
+
+namespace
+{
+
+// Runs the conversion with a collector of its own and lists what it reported
+QStringList diagnosticsOf(const std::function<void()>& convert)
+{
+	Diagnostics::Collector collector;
+	{
+		Diagnostics::Scope scope({&collector, "test", "description"});
+		convert();
+	}
+	QStringList list;
+	for(const auto& record : collector.records())
+		list << QString::fromLatin1(Diagnostics::severityName(record.severity)) + " " + record.code + " " +
+		        record.message + " x" + QString::number(record.count);
+	return list;
+}
+
+}
+
+class TestMarkdownConverters : public QObject
+{
+	Q_OBJECT
+private slots:
+	void streamMatchesDOM_data();
+	void streamMatchesDOM();
+};
+
+void TestMarkdownConverters::streamMatchesDOM_data()
+{
+	QTest::addColumn<QByteArray>("html");
+	QTest::addColumn<bool>("footnotesToRefs");
+	// Whether the single-pass converter handles the description, or leaves it to the DOM
+	QTest::addColumn<bool>("streamed");
+
+	const QByteArray footnotes =
+		"<h1>Sky</h1><p>Text with a note<sup><a href=\"#footnote-1\">1</a></sup>.</p>"
+		"<h2>References</h2><p id=\"footnote-1\">[1] The source of the note</p>";
+
+	QTest::newRow("headings and emphasis")
+		<< QByteArray("<h1>Sky</h1><p>Some <i>italic </i>and <b> bold</b> text with a <a href=\"https://example.org/\">link</a>.</p>"
+		              "<h2>Introduction</h2><p>Line<br>break</p><h3>Details</h3><p><em>emphasis</em></p>")
+		<< false << true;
+	QTest::newRow("repeated h1")
+		<< QByteArray("<h1>Sky</h1><p>a</p><h1>Again</h1><p>b</p>") << false << true;
+	QTest::newRow("heading before h1")
+		<< QByteArray("<h2>Early</h2><h1>Sky</h1><p>a</p>") << false << true;
+	QTest::newRow("lists")
+		<< QByteArray("<h1>Sky</h1><p>Lists:</p><ul><li>one</li><li><b>two</b></li></ul><ol><li>first</li><li>second<br>line</li></ol>")
+		<< false << true;
+	QTest::newRow("tables")
+		<< QByteArray("<h1>Sky</h1><table><tr><th>Name</th><th>Stars</th></tr><tr><td>Orion</td><td>7</td></tr></table>"
+		              "<table><tr><td>headerless</td><td><i>row</i></td></tr></table>")
+		<< false << true;
+	QTest::newRow("blockquote and images")
+		<< QByteArray("<h1>Sky</h1><blockquote><p>quoted</p><p>text</p></blockquote>"
+		              "<p><img src=\"illustrations/a.png\" alt=\"A\"><img src=\"illustrations/b.png\" width=\"100\" alt=\"B\"></p>")
+		<< false << true;
+	QTest::newRow("link with brackets")
+		<< QByteArray("<h1>Sky</h1><p><a href=\"https://example.org/\">[1]</a></p>") << false << true;
+	QTest::newRow("comments")
+		<< QByteArray("<h1>Sky</h1><!-- a note for translators --><p>text<!-- inline --></p>") << false << true;
+	QTest::newRow("entities")
+		<< QByteArray("<h1>Sky</h1><p>a&nbsp;b &amp; c &lt;d&gt; &copy; 2024 &#8212; &eacute;t&eacute;</p>") << false << true;
+	QTest::newRow("whitespace-only text nodes")
+		<< QByteArray("<h1>Sky</h1>\n<p><b>bold</b> <i>italic</i></p>\n<ul>\n  <li>a</li>\n  <li>b</li>\n</ul>\n"
+		              "<table>\n<tr>\n<td>x</td>\n</tr>\n</table>\n<p><b>x</b>&nbsp;<i>y</i></p>\n")
+		<< false << true;
+	QTest::newRow("unhandled element")
+		<< QByteArray("<h1>Sky</h1><p>before <span>inside</span> after</p>") << false << true;
+	QTest::newRow("footnotes to references") << footnotes << true << true;
+
+	QTest::newRow("footnotes kept") << footnotes << false << false;
+	QTest::newRow("sup") << QByteArray("<h1>Sky</h1><p>10<sup>3</sup> stars</p>") << true << false;
+	QTest::newRow("sub") << QByteArray("<h1>Sky</h1><p>H<sub>2</sub>O</p>") << false << false;
+	QTest::newRow("dl") << QByteArray("<h1>Sky</h1><dl><dt>term</dt><dd>definition</dd></dl>") << false << false;
+	QTest::newRow("layout table")
+		<< QByteArray("<h1>Sky</h1><table class=\"layout\"><tr><td>x</td><td>y</td></tr></table>") << false << false;
+	QTest::newRow("colspan")
+		<< QByteArray("<h1>Sky</h1><table><tr><td colspan=\"2\">x</td></tr><tr><td>a</td><td>b</td></tr></table>")
+		<< false << false;
+	QTest::newRow("heading in a list")
+		<< QByteArray("<h1>Sky</h1><ul><li><h2>title</h2></li></ul>") << false << false;
+}
+
+void TestMarkdownConverters::streamMatchesDOM()
+{
+	QFETCH(QByteArray, html);
+	QFETCH(bool, footnotesToRefs);
+	QFETCH(bool, streamed);
+
+	const auto xhtml = tidyDescriptionHTML(html);
+	QVERIFY(!xhtml.isEmpty());
+
+	QString dom;
+	const auto domDiagnostics = diagnosticsOf([&]{ dom = convertXHTMLToMarkdownWithDOM(xhtml, footnotesToRefs); });
+	QVERIFY(!dom.isEmpty());
+
+	std::optional<QString> stream;
+	const auto streamDiagnostics = diagnosticsOf([&]{ stream = convertXHTMLToMarkdown(xhtml, footnotesToRefs); });
+	QCOMPARE(stream.has_value(), streamed);
+	if(!stream)
+	{
+		// Nothing may be reported before falling back, as the DOM converter reports it all again
+		QCOMPARE(streamDiagnostics, QStringList());
+		return;
+	}
+	QCOMPARE(*stream, dom);
+	QCOMPARE(streamDiagnostics, domDiagnostics);
+}
+
+QTEST_GUILESS_MAIN(TestMarkdownConverters)
+#include "testMarkdownConverters.moc"
@@ -0,0 +1,173 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <gettext-po.h>
+#include "PoUtils.hpp"
+
+namespace
+{
+
+struct Message
+{
+	QString msgid;
+	QString msgstr;
+	QString comments;
+};
+
+const QString header =
+	"Project-Id-Version: PACKAGE VERSION\n"
+	"MIME-Version: 1.0\n"
+	"Content-Type: text/plain; charset=UTF-8\n"
+	"Content-Transfer-Encoding: 8bit\n"
+	"Language: ja\n";
+
+void xerror(int, po_message_t, const char* filename, size_t lineno, size_t column, int, const char* text)
+{
+	qWarning().nospace() << "libgettextpo: " << filename << ":" << lineno << ":" << column << ": " << text;
+}
+
+void xerror2(int, po_message_t, const char*, size_t, size_t, int, const char* text1,
+             po_message_t, const char*, size_t, size_t, int, const char* text2)
+{
+	qWarning().nospace() << "libgettextpo: " << text1 << "; " << text2;
+}
+
+// Writes the messages after the header the way DescriptionOldLoader::dump() does it with libgettextpo
+QByteArray writeWithGettext(const QString& path, const std::vector<Message>& messages)
+{
+	const auto file = po_file_create();
+	const auto iterator = po_message_iterator(file, nullptr);
+	const auto add = [iterator](const Message& message)
+	{
+		const auto msg = po_message_create();
+		if(!message.comments.isEmpty())
+			po_message_set_extracted_comments(msg, message.comments.toStdString().c_str());
+		po_message_set_msgid(msg, message.msgid.toStdString().c_str());
+		po_message_set_msgstr(msg, message.msgstr.toStdString().c_str());
+		po_message_insert(iterator, msg);
+	};
+	add({"", header, {}});
+	for(const auto& message : messages)
+		add(message);
+	po_message_iterator_free(iterator);
+	po_xerror_handler handler = {xerror, xerror2};
+	po_file_write(file, path.toStdString().c_str(), &handler);
+	po_file_free(file);
+
+	QFile written(path);
+	if(!written.open(QFile::ReadOnly))
+		return {};
+	return written.readAll();
+}
+
+QByteArray writeNatively(const std::vector<Message>& messages)
+{
+	PoUtils::PoWriter writer;
+	writer.addMessage("", header);
+	for(const auto& message : messages)
+		writer.addMessage(message.msgid, message.msgstr, message.comments);
+	return writer.data();
+}
+
+}
+
+class TestPoWriter : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void singleMessage_data();
+	void singleMessage();
+	void wholeCatalog();
+private:
+	std::vector<Message> samples() const;
+	QTemporaryDir dir;
+};
+
+void TestPoWriter::initTestCase()
+{
+	QVERIFY(dir.isValid());
+}
+
+std::vector<Message> TestPoWriter::samples() const
+{
+	const QString longSentence = "The constellation figures of this sky culture were recorded by several "
+	                             "ethnographers, whose accounts differ in the details of the figures and the stars they include.";
+	return {
+		{"Orion", "オリオン", "Western constellation"},
+		{longSentence, longSentence.toUpper(), "Description of the sky culture"},
+		{"See https://example.org/a/very/long/path/to/a/page/about/the/sky/culture/with-many-segments/index.html?lang=en&section=constellations",
+		 "", {}},
+		{"Tabs\tquotes \"here\" and a backslash \\ and a bell \a and a carriage return \r",
+		 "Tabulations\tguillemets \"ici\" et \\", {}},
+		{"First line\nSecond line\n\nFourth line after an empty one\n", "Première ligne\nDeuxième ligne\n\n", {}},
+		{"Ends with a newline that must not be left alone on a line after a long text that wraps around\n", "", {}},
+		{"Comments", "", "First comment line\nSecond comment line\n\nAfter an empty comment line\n"},
+		{"昔々、ある村に星を眺めるのが好きな子供たちがいました。彼らは毎晩空を見上げ、星座の物語を語り合いました。そして季節が移り変わるごとに、新しい星々が東の空から昇ってくるのを見守りました。",
+		 "", "CJK text without spaces"},
+		{"中文描述：北斗七星（大熊座的一部分）在中国古代天文学中具有重要地位，它被用来确定季节和时间，并且与许多神话传说紧密相连。",
+		 "", {}},
+		{"Звёздное небо народов Севера — это богатая традиция, в которой созвездия связаны с охотой, оленеводством и мифами о сотворении мира.",
+		 "", {}},
+		{"Combining marks: étoile, ñ, and an emoji 🌟 in a line that is long enough to get wrapped somewhere",
+		 "", {}},
+		{"Hyphenated-words-that-are-long-enough-to-need-wrapping-at-some-point-in-the-middle-of-the-line-somewhere",
+		 "", {}},
+		{"Numbers 1,234.56 and 99% and $100 and (parenthesized text) and [brackets] near the wrapping column",
+		 "", {}},
+		{QString(77, QChar('x')), QString(78, QChar('y')), {}},
+		{QString("a ").repeated(60), "", {}},
+		{"Non-breaking\u00a0spaces\u00a0keep\u00a0words\u00a0together\u00a0across\u00a0the\u00a0whole\u00a0line\u00a0until\u00a0it\u00a0ends, and then it may wrap",
+		 "", {}},
+	};
+}
+
+void TestPoWriter::singleMessage_data()
+{
+	QTest::addColumn<QString>("msgid");
+	QTest::addColumn<QString>("msgstr");
+	QTest::addColumn<QString>("comments");
+	int n = 0;
+	for(const auto& message : samples())
+		QTest::newRow(QByteArray::number(n++).constData()) << message.msgid << message.msgstr << message.comments;
+}
+
+void TestPoWriter::singleMessage()
+{
+	QFETCH(QString, msgid);
+	QFETCH(QString, msgstr);
+	QFETCH(QString, comments);
+	const std::vector<Message> messages{{msgid, msgstr, comments}};
+	const auto expected = writeWithGettext(dir.filePath(QTest::currentDataTag() + QString(".po")), messages);
+	QVERIFY(!expected.isEmpty());
+	QCOMPARE(writeNatively(messages), expected);
+}
+
+void TestPoWriter::wholeCatalog()
+{
+	const auto messages = samples();
+	const auto expected = writeWithGettext(dir.filePath("catalog.po"), messages);
+	QVERIFY(!expected.isEmpty());
+	QCOMPARE(writeNatively(messages), expected);
+}
+
+QTEST_GUILESS_MAIN(TestPoWriter)
+#include "testPoWriter.moc"
@@ -0,0 +1,58 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include "DescriptionOldLoader.hpp"
+
+class TestSubsections : public QObject
+{
+	Q_OBJECT
+private slots:
+	void appendSubsection_data();
+	void appendSubsection();
+};
+
+void TestSubsections::appendSubsection_data()
+{
+	QTest::addColumn<QString>("body");
+	QTest::addColumn<QString>("expectedEnd");
+	QTest::newRow("plain") << "Body B" << "\n\nBody B";
+	QTest::newRow("ASCII spaces") << "Body B \t\n" << "\n\nBody B";
+	QTest::newRow("no-break space") << QString(u"Body B\u00a0") << "\n\nBody B";
+	QTest::newRow("ideographic space") << QString(u"\u6587\u3000\u3000") << QString(u"\n\n\u6587");
+	QTest::newRow("mixed") << QString(u"Body B \u00a0\u3000\n") << "\n\nBody B";
+	QTest::newRow("inner no-break space") << QString(u"Body\u00a0B") << QString(u"\n\nBody\u00a0B");
+	QTest::newRow("empty") << "" << "";
+}
+
+void TestSubsections::appendSubsection()
+{
+	QFETCH(QString, body);
+	QFETCH(QString, expectedEnd);
+
+	// The trailing whitespace of every subsection is stripped before the next heading is appended
+	QString markdown = "Intro";
+	::appendSubsection(markdown, 2, "A", QString(u"Body A\u00a0\u3000"));
+	QCOMPARE(markdown, QString("Intro\n\n## A\n\nBody A"));
+	::appendSubsection(markdown, 3, "B", body);
+	QCOMPARE(markdown, "Intro\n\n## A\n\nBody A\n\n### B" + expectedEnd);
+}
+
+QTEST_GUILESS_MAIN(TestSubsections)
+#include "testSubsections.moc"
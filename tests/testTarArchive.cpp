@@ -0,0 +1,250 @@
+/*
+ * Stellarium Sky Culture Converter
+ * Copyright (C) 2025 Ruslan Kabatsayev
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include <QtTest>
+#include <QBuffer>
+#include <cstring>
+#include <zlib.h>
+#include "TarArchive.hpp"
+
+Q_DECLARE_METATYPE(TarArchive::Files)
+
+namespace
+{
+
+// Lists the files as "path=contents" lines, which QCOMPARE can print
+QStringList listing(const TarArchive::Files& files)
+{
+	QStringList lines;
+	for(const auto& [path, contents] : files)
+		lines += path + '=' + QString::fromUtf8(contents);
+	return lines;
+}
+
+QByteArray written(const TarArchive::Files& files, const bool gzip)
+{
+	QByteArray archive;
+	QBuffer buffer(&archive);
+	buffer.open(QIODevice::WriteOnly);
+	TarArchive::Writer writer(buffer, gzip);
+	for(const auto& [path, contents] : files)
+		writer.addFile(path, contents);
+	writer.finish();
+	return archive;
+}
+
+const QByteArray ustarMagic("ustar\0" "00", 8);
+const QByteArray oldGNUMagic("ustar  \0", 8);
+
+// A header block of the given type followed by the padded contents, built by hand for the kinds
+// of entries that the Writer doesn't produce
+QByteArray tarEntry(const QByteArray& name, const char type, const QByteArray& contents,
+                    const QByteArray& magic = ustarMagic, const QByteArray& prefixField = {})
+{
+	QByteArray header(512, '\0');
+	const auto put = [&header](const int offset, const QByteArray& value) {
+		std::memcpy(header.data() + offset, value.constData(), value.size());
+	};
+	put(0, name);
+	put(100, "0000644");
+	put(108, "0000000");
+	put(116, "0000000");
+	put(124, QByteArray::number(contents.size(), 8).rightJustified(11, '0'));
+	put(136, "00000000000");
+	header[156] = type;
+	put(257, magic);
+	put(345, prefixField);
+
+	put(148, "        ");
+	unsigned checksum = 0;
+	for(const char c : header)
+		checksum += static_cast<unsigned char>(c);
+	put(148, QByteArray::number(checksum, 8).rightJustified(6, '0') + '\0' + ' ');
+
+	const auto padding = (512 - contents.size() % 512) % 512;
+	return header + contents + QByteArray(padding, '\0');
+}
+
+QByteArray paxRecord(const QByteArray& key, const QByteArray& value)
+{
+	// The length includes its own digits
+	const auto rest = ' ' + key + '=' + value + '\n';
+	auto length = rest.size() + 1;
+	while(QByteArray::number(length).size() + rest.size() != length)
+		++length;
+	return QByteArray::number(length) + rest;
+}
+
+QByteArray gzipped(const QByteArray& data)
+{
+	z_stream stream = {};
+	deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+	QByteArray out(qsizetype(deflateBound(&stream, data.size())), '\0');
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+	stream.avail_in = static_cast<uInt>(data.size());
+	stream.next_out = reinterpret_cast<Bytef*>(out.data());
+	stream.avail_out = static_cast<uInt>(out.size());
+	deflate(&stream, Z_FINISH);
+	out.resize(stream.total_out);
+	deflateEnd(&stream);
+	return out;
+}
+
+const QByteArray endMarker(1024, '\0');
+
+}
+
+class TestTarArchive : public QObject
+{
+	Q_OBJECT
+private slots:
+	void roundTrip_data();
+	void roundTrip();
+	void pathTooLong();
+	void longNames_data();
+	void longNames();
+	void stripRootDirectory_data();
+	void stripRootDirectory();
+};
+
+void TestTarArchive::roundTrip_data()
+{
+	QTest::addColumn<TarArchive::Files>("files");
+	QTest::addColumn<bool>("gzip");
+
+	const QString longDir = "culture/" + QString(120, 'd');
+	const QString longName = QString(100, 'n');
+	const std::pair<const char*, TarArchive::Files> samples[] = {
+		{"plain", {{"culture/index.json", "{}"}, {"culture/description.md", "# Culture\n"}}},
+		{"block sizes", {{"empty", ""}, {"one block", QByteArray(512, 'x')}, {"more than a block", QByteArray(513, 'y')}}},
+		{"UTF-8 path", {{"kultúra/名前.md", "UTF-8"}}},
+		// Longer than the name field, so split into the prefix and name fields
+		{"long paths", {{longDir + "/file.md", "prefixed"}, {"culture/" + longName, "full name field"}}},
+	};
+	for(const auto& [name, files] : samples)
+	{
+		QTest::newRow(name) << files << false;
+		QTest::newRow((name + QByteArray(" gzip")).constData()) << files << true;
+	}
+}
+
+void TestTarArchive::roundTrip()
+{
+	QFETCH(TarArchive::Files, files);
+	QFETCH(bool, gzip);
+
+	const auto archive = written(files, gzip);
+	QCOMPARE(archive.startsWith("\x1f\x8b"), gzip);
+	if(!gzip)
+		QCOMPARE(archive.size() % 512, 0);
+
+	TarArchive::Files read;
+	QVERIFY(TarArchive::read(archive, read));
+	QCOMPARE(listing(read), listing(files));
+}
+
+void TestTarArchive::pathTooLong()
+{
+	QByteArray archive;
+	QBuffer buffer(&archive);
+	buffer.open(QIODevice::WriteOnly);
+	TarArchive::Writer writer(buffer, false);
+	// The last component doesn't fit in the name field
+	QVERIFY(!writer.addFile("culture/" + QString(101, 'n'), "data"));
+	// Nor does the rest fit in the prefix field
+	TarArchive::Writer secondWriter(buffer, false);
+	QVERIFY(!secondWriter.addFile(QString(160, 'd') + "/file.md", "data"));
+}
+
+void TestTarArchive::longNames_data()
+{
+	QTest::addColumn<QByteArray>("archive");
+	QTest::addColumn<TarArchive::Files>("files");
+
+	const QByteArray longPath = "culture/" + QByteArray(300, 'l') + "/description.md";
+	const auto file = tarEntry("culture/file.md", '0', "file");
+
+	const auto gnu = tarEntry("././@LongLink", 'L', longPath + '\0') + tarEntry("truncated", '0', "long") + file + endMarker;
+	QTest::newRow("GNU long name") << gnu << TarArchive::Files{{longPath, "long"}, {"culture/file.md", "file"}};
+	QTest::newRow("GNU long name gzip") << gzipped(gnu) << TarArchive::Files{{longPath, "long"}, {"culture/file.md", "file"}};
+
+	const auto pax = tarEntry("PaxHeaders/x", 'x', paxRecord("mtime", "0") + paxRecord("path", longPath)) +
+	                 tarEntry("truncated", '0', "long") + file + endMarker;
+	QTest::newRow("pax path") << pax << TarArchive::Files{{longPath, "long"}, {"culture/file.md", "file"}};
+	QTest::newRow("pax path gzip") << gzipped(pax) << TarArchive::Files{{longPath, "long"}, {"culture/file.md", "file"}};
+
+	// A global pax header applies to no single entry
+	const auto global = tarEntry("pax_global_header", 'g', paxRecord("comment", "x")) + file + endMarker;
+	QTest::newRow("global pax header") << global << TarArchive::Files{{"culture/file.md", "file"}};
+
+	// Old GNU headers keep the access and change times where ustar has the prefix
+	const auto oldGNU = tarEntry("culture/old.md", '0', "old", oldGNUMagic, "00000000000") + endMarker;
+	QTest::newRow("old GNU header") << oldGNU << TarArchive::Files{{"culture/old.md", "old"}};
+
+	const auto prefixed = tarEntry("file.md", '0', "prefixed", ustarMagic, "culture/dir") + endMarker;
+	QTest::newRow("ustar prefix") << prefixed << TarArchive::Files{{"culture/dir/file.md", "prefixed"}};
+
+	// Directories are skipped, and the end-of-archive marker is optional
+	const auto directory = tarEntry("culture/", '5', "") + file;
+	QTest::newRow("directory, no end marker") << directory << TarArchive::Files{{"culture/file.md", "file"}};
+}
+
+void TestTarArchive::longNames()
+{
+	QFETCH(QByteArray, archive);
+	QFETCH(TarArchive::Files, files);
+
+	TarArchive::Files read;
+	QVERIFY(TarArchive::read(archive, read));
+	QCOMPARE(listing(read), listing(files));
+}
+
+void TestTarArchive::stripRootDirectory_data()
+{
+	QTest::addColumn<TarArchive::Files>("files");
+	QTest::addColumn<QString>("root");
+	QTest::addColumn<TarArchive::Files>("stripped");
+
+	QTest::newRow("one root") << TarArchive::Files{{"culture/index.json", "{}"}, {"culture/a/b.md", "b"}}
+	                          << "culture" << TarArchive::Files{{"index.json", "{}"}, {"a/b.md", "b"}};
+	QTest::newRow("two roots") << TarArchive::Files{{"one/index.json", "1"}, {"two/index.json", "2"}}
+	                           << "" << TarArchive::Files{{"one/index.json", "1"}, {"two/index.json", "2"}};
+	QTest::newRow("file at the top") << TarArchive::Files{{"culture/index.json", "{}"}, {"README", "r"}}
+	                                 << "" << TarArchive::Files{{"culture/index.json", "{}"}, {"README", "r"}};
+	// A common start of the name doesn't make a directory
+	QTest::newRow("common name prefix") << TarArchive::Files{{"culture/index.json", "{}"}, {"culture2/index.json", "2"}}
+	                                    << "" << TarArchive::Files{{"culture/index.json", "{}"}, {"culture2/index.json", "2"}};
+	QTest::newRow("empty") << TarArchive::Files{} << "" << TarArchive::Files{};
+}
+
+void TestTarArchive::stripRootDirectory()
+{
+	QFETCH(TarArchive::Files, files);
+	QFETCH(QString, root);
+	QFETCH(TarArchive::Files, stripped);
+
+	// Through an archive, as the converter gets them
+	TarArchive::Files read;
+	QVERIFY(TarArchive::read(written(files, true), read));
+	QCOMPARE(TarArchive::stripRootDirectory(read), root);
+	QCOMPARE(listing(read), listing(stripped));
+}
+
+QTEST_GUILESS_MAIN(TestTarArchive)
+#include "testTarArchive.moc"